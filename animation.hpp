@@ -0,0 +1,59 @@
+#ifndef SAND_HEADER_ANIMATION
+#	define SAND_HEADER_ANIMATION
+#
+#	include "chunk.hpp"
+#	include "texture.hpp"
+#	include "tile.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+
+namespace sand {
+	[[nodiscard]] constexpr xte::u64 texture_frame(xte::u64 texture, xte::u64 tick) noexcept {
+		return sand::textures[texture].frames[tick % sand::textures[texture].frames_count];
+	}
+
+	// Ticks before each texture repeats, or zero for textures that always show the same frame
+	inline constexpr auto texture_periods = ([] {
+		xte::fixed_array<xte::u64, sand::textures.size()> periods = {};
+		for (xte::uz texture = 0; texture < sand::textures.size(); ++texture) {
+			for (xte::uz frame = 1; frame < sand::textures[texture].frames_count; ++frame) {
+				if (sand::textures[texture].frames[frame] != sand::textures[texture].frames[0]) {
+					periods[texture] = sand::textures[texture].frames_count;
+				}
+			}
+		}
+		return periods;
+	})();
+
+	inline constexpr auto tile_animated = ([] {
+		xte::fixed_array<bool, sand::tiles.size()> animated = {};
+		for (xte::uz tile = 0; tile < sand::tiles.size(); ++tile) {
+			animated[tile] = sand::texture_periods[sand::tiles[tile].texture_index];
+		}
+		return animated;
+	})();
+
+	[[nodiscard]] constexpr bool frame_changed(xte::u64 texture, xte::u64 from_tick, xte::u64 to_tick) noexcept {
+		return sand::texture_periods[texture] && (sand::texture_frame(texture, from_tick) != sand::texture_frame(texture, to_tick));
+	}
+
+	// Chunks without animated tiles are never scanned
+	[[nodiscard]] constexpr sand::tile_mask animated_tiles(const sand::chunk& chunk, const sand::tile_histogram& histogram) noexcept {
+		sand::tile_mask animated;
+		bool any = false;
+		for (xte::uz tile = 1; tile < sand::tiles.size(); ++tile) {
+			any |= sand::tile_animated[tile] && histogram.count(static_cast<sand::tile_id>(tile));
+		}
+		if (any) {
+			for (xte::uz i = 0; i < (sand::chunk_w * sand::chunk_h); ++i) {
+				if (sand::tile_animated[chunk.data[i]]) {
+					animated.set(i);
+				}
+			}
+		}
+		return animated;
+	}
+}
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef SAND_HEADER_CHUNK
+#	define SAND_HEADER_CHUNK
+#
+#	include "pos.hpp"
+#	include "tile.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <bit>
+#	include <vector>
+
+namespace sand {
+	// Tiles are stored row-major, so iterating a chunk walks rows bottom to top and each row left to right
+	struct chunk {
+		xte::fixed_array<sand::tile_id, sand::chunk_w * sand::chunk_h> data;
+
+		[[nodiscard]] constexpr sand::tile_id& at(xte::u64 x, xte::u64 y) noexcept {
+			return this->data[y * sand::chunk_w + x];
+		}
+
+		[[nodiscard]] constexpr const sand::tile_id& at(xte::u64 x, xte::u64 y) const noexcept {
+			return this->data[y * sand::chunk_w + x];
+		}
+
+		[[nodiscard]] constexpr sand::tile_id* row(xte::u64 y) noexcept {
+			return this->data.data() + y * sand::chunk_w;
+		}
+
+		[[nodiscard]] constexpr const sand::tile_id* row(xte::u64 y) const noexcept {
+			return this->data.data() + y * sand::chunk_w;
+		}
+
+		[[nodiscard]] constexpr auto begin() noexcept {
+			return this->data.begin();
+		}
+
+		[[nodiscard]] constexpr auto begin() const noexcept {
+			return this->data.begin();
+		}
+
+		[[nodiscard]] constexpr auto end() noexcept {
+			return this->data.end();
+		}
+
+		[[nodiscard]] constexpr auto end() const noexcept {
+			return this->data.end();
+		}
+
+		[[nodiscard]] friend constexpr bool operator==(const sand::chunk&, const sand::chunk&) noexcept = default;
+	};
+
+	// One bit per tile, in the same row-major order as `sand::chunk`
+	struct tile_mask {
+		xte::fixed_array<xte::u64, sand::chunk_w * sand::chunk_h / 64> words = {};
+
+		constexpr void set(xte::uz index) noexcept {
+			this->words[index / 64] |= xte::u64(1) << (index % 64);
+		}
+
+		constexpr void reset(xte::uz index) noexcept {
+			this->words[index / 64] &= ~(xte::u64(1) << (index % 64));
+		}
+
+		constexpr void reset() noexcept {
+			std::ranges::fill(this->words, 0);
+		}
+
+		[[nodiscard]] constexpr bool test(xte::uz index) const noexcept {
+			return (this->words[index / 64] >> (index % 64)) & 1;
+		}
+
+		[[nodiscard]] constexpr bool any() const noexcept {
+			return std::ranges::any_of(this->words, [](xte::u64 word) -> bool { return word; });
+		}
+
+		// Clears and returns the lowest set bit, so bits cleared between calls are skipped
+		[[nodiscard]] constexpr bool take(xte::uz& index) noexcept {
+			for (xte::uz word = 0; word < this->words.size(); ++word) {
+				if (this->words[word]) {
+					index = word * 64 + static_cast<xte::uz>(std::countr_zero(this->words[word]));
+					this->reset(index);
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+
+	// Void is counted as whatever the other tiles leave, so a zeroed histogram describes an all-void chunk
+	struct tile_histogram {
+		xte::fixed_array<xte::u16, sand::tiles.size()> counts = {};
+		xte::u16 filled = 0;
+
+		[[nodiscard]] constexpr xte::u64 count(sand::tile_id tile) const noexcept {
+			return tile ? this->counts[tile] : (sand::chunk_w * sand::chunk_h - this->filled);
+		}
+
+		[[nodiscard]] constexpr bool empty() const noexcept {
+			return !this->filled;
+		}
+
+		[[nodiscard]] constexpr bool uniform() const noexcept {
+			return this->empty() || (std::ranges::find(this->counts, sand::chunk_w * sand::chunk_h) != this->counts.end());
+		}
+
+		constexpr void add(sand::tile_id tile) noexcept {
+			if (tile) {
+				++this->counts[tile];
+				++this->filled;
+			}
+		}
+
+		constexpr void remove(sand::tile_id tile) noexcept {
+			if (tile) {
+				--this->counts[tile];
+				--this->filled;
+			}
+		}
+
+		[[nodiscard]] friend constexpr bool operator==(const sand::tile_histogram&, const sand::tile_histogram&) noexcept = default;
+	};
+
+	[[nodiscard]] constexpr sand::tile_histogram count_tiles(const sand::chunk& chunk) noexcept {
+		sand::tile_histogram histogram;
+		for (auto&& tile : chunk) {
+			histogram.add(tile);
+		}
+		return histogram;
+	}
+
+	using light_map = xte::fixed_array<xte::u8, sand::chunk_w * sand::chunk_h>;
+
+	// Extra data for the few tiles that need it, sorted by tile index so it is walked in the same order as the tiles
+	struct tile_state {
+		xte::u16 index;
+		xte::u32 value;
+
+		[[nodiscard]] friend constexpr bool operator==(const sand::tile_state&, const sand::tile_state&) noexcept = default;
+	};
+
+	using chunk_state = std::vector<sand::tile_state>;
+
+	struct chunk_pos {
+		xte::u64 x;
+		xte::u64 y;
+
+		[[nodiscard]] friend constexpr bool operator==(const sand::chunk_pos&, const sand::chunk_pos&) noexcept = default;
+	};
+
+	struct chunk_pos_hash {
+		[[nodiscard]] constexpr xte::uz operator()(const sand::chunk_pos& pos) const noexcept {
+			const xte::u64 hash = (pos.x * 0x9E3779B97F4A7C15) ^ (pos.y * 0xC2B2AE3D27D4EB4F);
+			return static_cast<xte::uz>(hash ^ (hash >> 32));
+		}
+	};
+
+	[[nodiscard]] constexpr bool chunk_uniform(const sand::chunk& chunk) noexcept {
+		for (auto&& tile : chunk) {
+			if (tile != chunk.at(0, 0)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	[[nodiscard]] constexpr xte::u64 chunk_hash(const sand::chunk& chunk) noexcept {
+		xte::u64 hash = 0xCBF29CE484222325;
+		for (auto&& tile : chunk) {
+			hash = (hash ^ tile) * 0x100000001B3;
+		}
+		return hash ^ (hash >> 29);
+	}
+
+	[[nodiscard]] constexpr sand::chunk_pos chunk_of(const sand::pos& pos) noexcept {
+		return { pos.chunk_x, pos.chunk_y };
+	}
+
+	// Index of a tile within its chunk's row-major grid
+	[[nodiscard]] constexpr xte::uz tile_index(const sand::pos& pos) noexcept {
+		return pos.tile_y * sand::chunk_w + pos.tile_x;
+	}
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SAND_HEADER_CHUNK_CODEC
+#	define SAND_HEADER_CHUNK_CODEC
+#
+#	include "chunk.hpp"
+#	include "tile.hpp"
+#
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <vector>
+
+namespace sand {
+	// Palette size, palette, then one byte per run holding the palette index and length in nibbles
+	// Chunks with more than 16 distinct tiles, or that would not shrink, pack to nothing
+	[[nodiscard]] inline std::vector<xte::u8> pack_chunk(const sand::chunk& chunk) {
+		std::vector<xte::u8> palette;
+		for (auto&& tile : chunk) {
+			if (std::ranges::find(palette, tile) == palette.end()) {
+				if (palette.size() == 0x10) {
+					return {};
+				}
+				palette.push_back(tile);
+			}
+		}
+		std::vector<xte::u8> packed;
+		packed.push_back(static_cast<xte::u8>(palette.size()));
+		packed.insert(packed.end(), palette.begin(), palette.end());
+		xte::u8 run_tile = chunk.at(0, 0);
+		xte::u8 run_length = 0;
+		auto flush = [&] -> void {
+			const auto index = static_cast<xte::u8>(std::ranges::find(palette, run_tile) - palette.begin());
+			packed.push_back(static_cast<xte::u8>((index << 4) | (run_length - 1)));
+		};
+		for (auto&& tile : chunk) {
+			if ((tile != run_tile) || (run_length == 0x10)) {
+				flush();
+				if (packed.size() >= sizeof(sand::chunk)) {
+					return {};
+				}
+				run_tile = tile;
+				run_length = 0;
+			}
+			++run_length;
+		}
+		flush();
+		packed.shrink_to_fit();
+		return packed;
+	}
+
+	[[nodiscard]] inline sand::chunk unpack_chunk(const std::vector<xte::u8>& packed) noexcept {
+		sand::chunk chunk;
+		const xte::uz palette_size = packed[0];
+		xte::uz run = palette_size + 1;
+		xte::u8 run_length = 0;
+		for (auto& tile : chunk) {
+			if (!run_length) {
+				run_length = static_cast<xte::u8>((packed[run] & 0x0F) + 1);
+				++run;
+			}
+			tile = packed[1 + (packed[run - 1] >> 4)];
+			--run_length;
+		}
+		return chunk;
+	}
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef SAND_HEADER_ENCODE
+#	define SAND_HEADER_ENCODE
+#
+#	include "color.hpp"
+#	include "get_color.hpp"
+#	include "light.hpp"
+#	include "texture.hpp"
+#	include "texture_data.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <format>
+#	include <iterator>
+#	include <string>
+#	include <vector>
+
+namespace sand {
+	[[nodiscard]] constexpr sand::color3 shade(const sand::color4& color, xte::u8 brightness) noexcept {
+		return {
+			static_cast<xte::u8>(color.r * brightness / 0xFF),
+			static_cast<xte::u8>(color.g * brightness / 0xFF),
+			static_cast<xte::u8>(color.b * brightness / 0xFF)
+		};
+	}
+
+	// Cells are always written as 24-bit colors, the only mode the terminal output uses
+	inline void encode_cell(std::string& out, const sand::color3& top, const sand::color3& bottom) {
+		std::format_to(std::back_inserter(out), "\x1B[38;2;{};{};{}m\x1B[48;2;{};{};{}m▀", top.r, top.g, top.b, bottom.r, bottom.g, bottom.b);
+	}
+
+	inline constexpr xte::u64 cell_rows = sand::texture_h / 2;
+	inline constexpr xte::u64 light_shades = sand::max_light - sand::ambient_light + 1;
+
+	inline constexpr auto frame_opaque = ([] {
+		xte::fixed_array<bool, sand::texture_data.size()> opaque = {};
+		for (xte::uz frame = 0; frame < sand::texture_data.size(); ++frame) {
+			opaque[frame] = true;
+			for (xte::uz i = 0; i < (sand::texture_w * sand::texture_h); ++i) {
+				opaque[frame] = opaque[frame] && sand::get_color(sand::texture_data[frame][i]).a;
+			}
+		}
+		return opaque;
+	})();
+
+	// Light levels at or below ambient draw alike, so they share one shade
+	[[nodiscard]] constexpr xte::u64 light_shade(xte::u8 level) noexcept {
+		return std::max(level, sand::ambient_light) - sand::ambient_light;
+	}
+
+	// Names the texture row a cell was drawn from while one opaque texture covers it whole, and is zero otherwise
+	// The column is in the low bits, so the cells of one row count up by one from left to right
+	[[nodiscard]] constexpr xte::u32 cell_source(xte::u64 frame, xte::u8 level, xte::u64 row, xte::u64 col) noexcept {
+		return static_cast<xte::u32>(0x80000000 | (frame << 12) | (sand::light_shade(level) << 8) | (row << 4) | col);
+	}
+
+	struct encoded_row {
+		std::string bytes;
+		xte::fixed_array<xte::uz, sand::texture_w + 1> offsets;
+	};
+
+	// Every cell row of every opaque frame at every shade, encoded once at startup
+	inline const std::vector<sand::encoded_row> encoded_rows = ([] {
+		std::vector<sand::encoded_row> rows(sand::texture_data.size() * sand::light_shades * sand::cell_rows);
+		for (xte::uz frame = 0; frame < sand::texture_data.size(); ++frame) {
+			if (!sand::frame_opaque[frame]) {
+				continue;
+			}
+			for (xte::u64 shade = 0; shade < sand::light_shades; ++shade) {
+				const xte::u8 brightness = sand::light_brightness(static_cast<xte::u8>(sand::ambient_light + shade));
+				for (xte::u64 row = 0; row < sand::cell_rows; ++row) {
+					auto& encoded = rows[(frame * sand::light_shades + shade) * sand::cell_rows + row];
+					for (xte::u64 col = 0; col < sand::texture_w; ++col) {
+						encoded.offsets[col] = encoded.bytes.size();
+						sand::encode_cell(
+							encoded.bytes,
+							sand::shade(sand::get_color(sand::texture_data[frame][row * 2 * sand::texture_w + col]), brightness),
+							sand::shade(sand::get_color(sand::texture_data[frame][(row * 2 + 1) * sand::texture_w + col]), brightness)
+						);
+					}
+					encoded.offsets[sand::texture_w] = encoded.bytes.size();
+				}
+			}
+		}
+		return rows;
+	})();
+
+	// Appends `count` cells of one texture row, starting from the cell `source` names
+	inline void encode_cells(std::string& out, xte::u32 source, xte::u64 count) {
+		const xte::u64 col = source & 0xF;
+		const auto& row = sand::encoded_rows[((source >> 12) & 0x7FFFF) * sand::light_shades * sand::cell_rows + ((source >> 8) & 0xF) * sand::cell_rows + ((source >> 4) & 0xF)];
+		out.append(row.bytes, row.offsets[col], row.offsets[col + count] - row.offsets[col]);
+	}
+}
+
+#endif
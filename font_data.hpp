@@ -1,6 +1,7 @@
 #ifndef SAND_HEADER_FONT
 #	define SAND_HEADER_FONT
 #
+#	include <xte/data/fixed_array.hpp>
 #	include <xte/data/static_string_view.hpp>
 #	include <xte/util/number_types.hpp>
 #
@@ -591,6 +592,19 @@ namespace sand {
 			"    ";
 		return std::define_static_array(font_data);
 	})();
+
+	// One bit per pixel, row by row from the top, so each glyph row is `font_w` bits of its mask
+	inline constexpr auto font_masks = ([] {
+		xte::fixed_array<xte::u32, 1 << CHAR_BIT> font_masks = {};
+		for (std::size_t i = 0; i < (1 << CHAR_BIT); ++i) {
+			for (std::size_t pixel = 0; pixel < (sand::font_w * sand::font_h); ++pixel) {
+				if (sand::font_data[i][pixel] == '#') {
+					font_masks[i] |= xte::u32(1) << pixel;
+				}
+			}
+		}
+		return font_masks;
+	})();
 }
 
 #endif
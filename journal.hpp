@@ -0,0 +1,169 @@
+#ifndef SAND_HEADER_JOURNAL
+#	define SAND_HEADER_JOURNAL
+#
+#	include "chunk.hpp"
+#	include "log.hpp"
+#	include "pos.hpp"
+#	include "save.hpp"
+#	include "tile.hpp"
+#
+#	include <xte/data/string.hpp>
+#	include <xte/io/file.hpp>
+#	include <xte/io/file_mode.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <fcntl.h>
+#	include <unistd.h>
+#
+#	include <algorithm>
+#	include <filesystem>
+#	include <format>
+#	include <string>
+#	include <vector>
+
+namespace sand {
+	struct journal_record {
+		sand::pos pos;
+		xte::u8 old_id;
+		xte::u8 new_id;
+		xte::u64 tick;
+	};
+
+	// chunk x, chunk y, tile index, old id, new id, tick, checksum of the rest
+	inline constexpr xte::uz journal_record_size = 8 + 8 + 2 + 1 + 1 + 8 + 4;
+
+	[[nodiscard]] constexpr xte::u32 journal_checksum(const char* data, xte::uz size) noexcept {
+		xte::u32 hash = 0x811C9DC5;
+		for (xte::uz i = 0; i < size; ++i) {
+			hash = (hash ^ static_cast<xte::u8>(data[i])) * 0x01000193;
+		}
+		return hash;
+	}
+	inline constexpr xte::uz journal_threshold = 0x10000;
+
+	inline int journal_fd = -1;
+	inline xte::u64 journal_segment = 0;
+	inline xte::uz journal_size = 0;
+	inline std::string journal_buffer;
+
+	[[nodiscard]] inline std::string journal_dir() {
+		return std::format("{}/journal", sand::save_dir);
+	}
+
+	[[nodiscard]] inline std::string journal_path(xte::u64 segment) {
+		return std::format("{}/{:0>16X}.bin", sand::journal_dir(), segment);
+	}
+
+	[[nodiscard]] inline std::vector<std::string> journal_segments() {
+		std::vector<std::string> segments;
+		if (std::filesystem::exists(sand::journal_dir())) {
+			for (const auto& segment : std::filesystem::directory_iterator(sand::journal_dir())) {
+				if (segment.path().extension() == ".bin") {
+					segments.push_back(segment.path().string());
+				}
+			}
+		}
+		std::ranges::sort(segments);
+		return segments;
+	}
+
+	inline void open_journal(xte::u64 segment) {
+		std::filesystem::create_directories(sand::journal_dir());
+		sand::journal_fd = ::open(sand::journal_path(segment).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if (sand::journal_fd < 0) {
+			sand::log("failed to open journal");
+			throw;
+		}
+		sand::journal_segment = segment;
+		sand::journal_size = 0;
+	}
+
+	inline void sync_journal() {
+		if (sand::journal_buffer.empty()) {
+			return;
+		}
+		for (xte::uz i = 0; i < sand::journal_buffer.size();) {
+			const ::ssize_t written = ::write(sand::journal_fd, sand::journal_buffer.data() + i, sand::journal_buffer.size() - i);
+			if (written < 0) {
+				sand::log("failed to write journal");
+				throw;
+			}
+			i += static_cast<xte::uz>(written);
+		}
+		::fdatasync(sand::journal_fd);
+		sand::journal_size += sand::journal_buffer.size();
+		sand::journal_buffer.clear();
+	}
+
+	// Starts a new segment and returns the paths made redundant once everything dirty so far is saved
+	[[nodiscard]] inline std::vector<std::string> rotate_journal() {
+		sand::sync_journal();
+		::close(sand::journal_fd);
+		std::vector<std::string> retired = sand::journal_segments();
+		sand::open_journal(sand::journal_segment + 1);
+		std::erase(retired, sand::journal_path(sand::journal_segment));
+		return retired;
+	}
+
+	inline void close_journal() {
+		sand::sync_journal();
+		::close(sand::journal_fd);
+		if (!sand::journal_size) {
+			std::filesystem::remove(sand::journal_path(sand::journal_segment));
+		}
+	}
+
+	[[nodiscard]] inline bool journal_full() noexcept {
+		return (sand::journal_size + sand::journal_buffer.size()) >= sand::journal_threshold;
+	}
+
+	inline void journal_edit(const sand::journal_record& record) {
+		auto put = [](xte::u64 value, xte::uz bytes) -> void {
+			for (xte::uz i = 0; i < bytes; ++i) {
+				sand::journal_buffer.push_back(static_cast<char>(value >> (i * 8)));
+			}
+		};
+		const xte::uz start = sand::journal_buffer.size();
+		put(record.pos.chunk_x, 8);
+		put(record.pos.chunk_y, 8);
+		put(sand::tile_index(record.pos), 2);
+		put(record.old_id, 1);
+		put(record.new_id, 1);
+		put(record.tick, 8);
+		put(sand::journal_checksum(sand::journal_buffer.data() + start, sand::journal_record_size - 4), 4);
+	}
+
+	// Stops at the first record that fails its checksum or names an impossible tile, since only a torn or zeroed tail follows
+	[[nodiscard]] inline std::vector<sand::journal_record> read_journal(const std::string& path) {
+		const xte::string data = xte::file(path, xte::file_mode::read).read();
+		std::vector<sand::journal_record> records;
+		for (xte::uz offset = 0; (offset + sand::journal_record_size) <= data.size(); offset += sand::journal_record_size) {
+			xte::uz i = offset;
+			auto get = [&](xte::uz bytes) -> xte::u64 {
+				xte::u64 value = 0;
+				for (xte::uz byte = 0; byte < bytes; ++byte) {
+					value |= static_cast<xte::u64>(static_cast<xte::u8>(data[i++])) << (byte * 8);
+				}
+				return value;
+			};
+			const xte::u64 chunk_x = get(8);
+			const xte::u64 chunk_y = get(8);
+			const xte::u64 tile = get(2);
+			const auto old_id = static_cast<xte::u8>(get(1));
+			const auto new_id = static_cast<xte::u8>(get(1));
+			const xte::u64 tick = get(8);
+			if ((get(4) != sand::journal_checksum(data.data() + offset, sand::journal_record_size - 4)) || (tile >= (sand::chunk_w * sand::chunk_h)) || (old_id >= sand::tiles.size()) || (new_id >= sand::tiles.size())) {
+				break;
+			}
+			records.push_back({ { chunk_x, chunk_y, tile % sand::chunk_w, tile / sand::chunk_w }, old_id, new_id, tick });
+		}
+		return records;
+	}
+
+	[[nodiscard]] inline xte::u64 journal_segment_of(const std::string& path) {
+		xte::uz i = 0;
+		return sand::parse_hex(std::filesystem::path(path).stem().string(), i);
+	}
+}
+
+#endif
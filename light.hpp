@@ -0,0 +1,153 @@
+#ifndef SAND_HEADER_LIGHT
+#	define SAND_HEADER_LIGHT
+#
+#	include "chunk.hpp"
+#	include "pos.hpp"
+#	include "tile.hpp"
+#	include "world.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <vector>
+
+namespace sand {
+	inline constexpr xte::u8 max_light = 0xF;
+	inline constexpr xte::u8 ambient_light = 0xA;
+
+	struct light_node {
+		sand::pos pos;
+		xte::u8 level;
+	};
+
+	inline std::vector<sand::light_node> light_removes;
+	inline std::vector<sand::pos> light_adds;
+
+	// Tiles whose light changed in the last update, so their drawing can be refreshed
+	inline std::vector<sand::pos> light_changes;
+
+	// Light is scaled so that a fully lit tile keeps its atlas colors and nothing drops below the ambient floor
+	[[nodiscard]] constexpr xte::u8 light_brightness(xte::u8 level) noexcept {
+		return static_cast<xte::u8>(std::max(level, sand::ambient_light) * 0xFF / sand::max_light);
+	}
+
+	[[nodiscard]] constexpr bool passes_light(sand::tile_id tile) noexcept {
+		return sand::tiles[tile].background || sand::tiles[tile].transparent;
+	}
+
+	inline void light_tile(sand::world_chunk& chunk, const sand::pos& pos, xte::u8 level) {
+		chunk.set_light(sand::tile_index(pos), level);
+		sand::light_changes.push_back(pos);
+	}
+
+	[[nodiscard]] inline xte::fixed_array<sand::pos, 4> light_neighbors(const sand::pos& pos) noexcept {
+		return { pos - sand::pos(0, 0, 1, 0), pos + sand::pos(0, 0, 1, 0), pos - sand::pos(0, 0, 0, 1), pos + sand::pos(0, 0, 0, 1) };
+	}
+
+	// Seeds a changed tile: its old light is removed, its neighbors flood back in, and it shines if it emits
+	inline void relight_tile(const sand::pos& pos) {
+		auto* chunk = sand::find_chunk(sand::chunk_of(pos));
+		if (!chunk) {
+			return;
+		}
+		if (const xte::u8 level = chunk->light_at(sand::tile_index(pos))) {
+			sand::light_tile(*chunk, pos, 0);
+			sand::light_removes.push_back({ pos, level });
+		}
+		for (auto&& neighbor : sand::light_neighbors(pos)) {
+			sand::light_adds.push_back(neighbor);
+		}
+		if (const xte::u8 emitted = sand::tiles[chunk->tiles().at(pos.tile_x, pos.tile_y)].light) {
+			sand::light_tile(*chunk, pos, emitted);
+			sand::light_adds.push_back(pos);
+		}
+	}
+
+	// Lights a newly resident chunk from its own emitters and from the edges of its resident neighbors
+	inline void light_chunk(const sand::chunk_pos& pos) {
+		const auto* chunk = sand::find_chunk(pos);
+		if (!chunk) {
+			return;
+		}
+		const sand::pos origin = sand::pos(pos.x, pos.y, 0, 0);
+		for (xte::u64 tile_y = 0; tile_y < sand::chunk_h; ++tile_y) {
+			for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+				if (sand::tiles[chunk->tiles().at(tile_x, tile_y)].light) {
+					sand::relight_tile(origin + sand::pos(0, 0, tile_x, tile_y));
+				}
+			}
+			sand::light_adds.push_back(origin - sand::pos(0, 0, 1, 0) + sand::pos(0, 0, 0, tile_y));
+			sand::light_adds.push_back(origin + sand::pos(0, 0, sand::chunk_w, tile_y));
+		}
+		for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+			sand::light_adds.push_back(origin - sand::pos(0, 0, 0, 1) + sand::pos(0, 0, tile_x, 0));
+			sand::light_adds.push_back(origin + sand::pos(0, 0, tile_x, sand::chunk_h));
+		}
+	}
+
+	// Darkens everything lit more dimly than a removed node, queueing brighter tiles on the edge to flood back in
+	inline void spread_removes() {
+		for (xte::uz i = 0; i < sand::light_removes.size(); ++i) {
+			const sand::light_node node = sand::light_removes[i];
+			for (auto&& neighbor : sand::light_neighbors(node.pos)) {
+				auto* chunk = sand::find_chunk(sand::chunk_of(neighbor));
+				if (!chunk) {
+					continue;
+				}
+				const xte::uz index = sand::tile_index(neighbor);
+				const xte::u8 level = chunk->light_at(index);
+				if (level && (level < node.level)) {
+					sand::light_tile(*chunk, neighbor, 0);
+					sand::light_removes.push_back({ neighbor, level });
+					if (const xte::u8 emitted = sand::tiles[chunk->tiles().at(neighbor.tile_x, neighbor.tile_y)].light) {
+						sand::light_tile(*chunk, neighbor, emitted);
+						sand::light_adds.push_back(neighbor);
+					}
+				} else if (level >= node.level) {
+					sand::light_adds.push_back(neighbor);
+				}
+			}
+		}
+		sand::light_removes.clear();
+	}
+
+	// Light steps down by one per tile, and spreads out of tiles that let it through or emit it
+	inline void spread_adds() {
+		for (xte::uz i = 0; i < sand::light_adds.size(); ++i) {
+			const sand::pos pos = sand::light_adds[i];
+			const auto* chunk = sand::find_chunk(sand::chunk_of(pos));
+			if (!chunk) {
+				continue;
+			}
+			const xte::u8 level = chunk->light_at(sand::tile_index(pos));
+			const sand::tile_id tile = chunk->tiles().at(pos.tile_x, pos.tile_y);
+			if ((level <= 1) || (!sand::passes_light(tile) && !sand::tiles[tile].light)) {
+				continue;
+			}
+			for (auto&& neighbor : sand::light_neighbors(pos)) {
+				auto* target = sand::find_chunk(sand::chunk_of(neighbor));
+				if (target && ((target->light_at(sand::tile_index(neighbor)) + 1) < level)) {
+					sand::light_tile(*target, neighbor, static_cast<xte::u8>(level - 1));
+					sand::light_adds.push_back(neighbor);
+				}
+			}
+		}
+		sand::light_adds.clear();
+	}
+
+	// Runs once per tick over the chunks inserted and the tiles changed since the last run, so work follows the affected region
+	inline void update_light() {
+		sand::light_changes.clear();
+		for (auto&& pos : sand::inserted_chunks) {
+			sand::light_chunk(pos);
+		}
+		for (auto&& change : sand::tile_changes) {
+			sand::relight_tile(change.pos);
+		}
+		sand::spread_removes();
+		sand::spread_adds();
+	}
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SAND_HEADER_LOG
+#	define SAND_HEADER_LOG
+#
+#	include <xte/data/string_view.hpp>
+#
+#	include <cstdio>
+#	include <print>
+
+namespace sand {
+	inline void log(xte::string_view message) noexcept {
+		std::println("{}\r", message);
+		std::fflush(stdout);
+	}
+}
+
+#endif
@@ -1,10 +1,25 @@
+#include "animation.hpp"
+#include "chunk.hpp"
 #include "color.hpp"
+#include "encode.hpp"
 #include "get_color.hpp"
 #include "font_data.hpp"
+#include "journal.hpp"
+#include "light.hpp"
+#include "log.hpp"
+#include "minimap.hpp"
+#include "mip.hpp"
 #include "pos.hpp"
+#include "save.hpp"
+#include "saver.hpp"
+#include "sim.hpp"
+#include "stats.hpp"
 #include "texture.hpp"
 #include "texture_data.hpp"
 #include "tile.hpp"
+#include "world.hpp"
+#include "world_file.hpp"
+#include "worldgen.hpp"
 
 #include <xte/data/fixed_array.hpp>
 #include <xte/data/is_whitespace.hpp>
@@ -12,25 +27,30 @@
 #include <xte/data/string_view.hpp>
 #include <xte/io/file.hpp>
 #include <xte/io/file_mode.hpp>
-#include <xte/math/less.hpp>
 #include <xte/math/parse_number.hpp>
 #include <xte/util/error.hpp>
 
 #include <fcntl.h>
 #include <stdio.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <climits>
+#include <bit>
 #include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <format>
+#include <functional>
 #include <print>
 #include <random>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 using namespace std::literals;
 
@@ -42,59 +62,54 @@ namespace sand {
 		[[nodiscard]] friend constexpr bool operator==(const sand::pixel_pos&, const sand::pixel_pos&) = default;
 	};
 
-	xte::u64 tick = 0;
 	sand::pos camera_pos = { 0, 0, 0, 0 };
 	sand::pos select_pos = { 0, 0, sand::chunk_w / 2, sand::chunk_h / 2 };
-	sand::tile select;
-
-	std::unordered_map<xte::u64, std::unordered_map<xte::u64, xte::fixed_array<xte::fixed_array<sand::tile, sand::chunk_h>, sand::chunk_w>>> world;
+	sand::tile_id select = 0x00;
 
 	bool inventory_open = false;
+	bool info_open = false;
+	bool minimap_open = false;
+	xte::u64 zoom = 0;
 	inline constexpr auto inventory = ([] {
-		xte::fixed_array<xte::fixed_array<sand::tile, sand::chunk_h>, sand::chunk_w> inventory;
-		for (xte::u64 x = 0; x < sand::chunk_w; ++x) {
-			for (xte::u64 y = 0; y < sand::chunk_h; ++y) {
-				inventory[x][y] = sand::tiles[0x00];
-			}
+		sand::chunk inventory;
+		for (auto& tile : inventory) {
+			tile = 0x00;
 		}
 		constexpr xte::u64 mid_x = sand::chunk_w / 2;
 		constexpr xte::u64 mid_y = sand::chunk_h / 2;
-		inventory[mid_x][mid_y] = sand::tiles[0x01]; // stone
-		inventory[mid_x][mid_y + 1] = sand::tiles[0x07]; // rock
-		inventory[mid_x][mid_y + 2] = sand::tiles[0x0E]; // slate
-		inventory[mid_x - 1][mid_y + 1] = sand::tiles[0x02]; // cobbled stone
-		inventory[mid_x + 1][mid_y + 1] = sand::tiles[0x10]; // stone bricks
-		inventory[mid_x - 1][mid_y] = sand::tiles[0x06]; // dirt
-		inventory[mid_x + 1][mid_y] = sand::tiles[0x09]; // wood
-		inventory[mid_x + 2][mid_y] = sand::tiles[0x0F]; // wood planks
-		inventory[mid_x][mid_y - 1] = sand::tiles[0x0C]; // ice
-		inventory[mid_x][mid_y - 2] = sand::tiles[0x0D]; // chiseled ice
-		inventory[mid_x - 1][mid_y - 1] = sand::tiles[0x0A]; // grass
-		inventory[mid_x - 2][mid_y - 1] = sand::tiles[0x0B]; // flowers
-		inventory[mid_x + 1][mid_y - 1] = sand::tiles[0x08]; // leaves
-		inventory[mid_x + 1][mid_y + 2] = sand::tiles[0x11]; // glass
-		inventory[mid_x + 2][mid_y - 1] = sand::tiles[0x05]; // rainbow
-		inventory[mid_x + 1][mid_y - 2] = sand::tiles[0x04]; // light blue
-		inventory[mid_x + 2][mid_y - 2] = sand::tiles[0x03]; // dark blue
-		inventory[mid_x - 1][mid_y + 2] = sand::tiles[0x12]; // conveyor right
-		inventory[mid_x - 2][mid_y + 2] = sand::tiles[0x13]; // conveyor left
-		inventory[mid_x - 1][mid_y + 3] = sand::tiles[0x14]; // conveyor up
-		inventory[mid_x - 2][mid_y + 1] = sand::tiles[0x15]; // conveyor down
+		inventory.at(mid_x, mid_y) = 0x01; // stone
+		inventory.at(mid_x, mid_y + 1) = 0x07; // rock
+		inventory.at(mid_x, mid_y + 2) = 0x0E; // slate
+		inventory.at(mid_x - 1, mid_y + 1) = 0x02; // cobbled stone
+		inventory.at(mid_x + 1, mid_y + 1) = 0x10; // stone bricks
+		inventory.at(mid_x - 1, mid_y) = 0x06; // dirt
+		inventory.at(mid_x + 1, mid_y) = 0x09; // wood
+		inventory.at(mid_x + 2, mid_y) = 0x0F; // wood planks
+		inventory.at(mid_x, mid_y - 1) = 0x0C; // ice
+		inventory.at(mid_x, mid_y - 2) = 0x0D; // chiseled ice
+		inventory.at(mid_x - 1, mid_y - 1) = 0x0A; // grass
+		inventory.at(mid_x - 2, mid_y - 1) = 0x0B; // flowers
+		inventory.at(mid_x + 1, mid_y - 1) = 0x08; // leaves
+		inventory.at(mid_x + 1, mid_y + 2) = 0x11; // glass
+		inventory.at(mid_x + 2, mid_y - 1) = 0x05; // rainbow
+		inventory.at(mid_x + 1, mid_y - 2) = 0x04; // light blue
+		inventory.at(mid_x + 2, mid_y - 2) = 0x03; // dark blue
+		inventory.at(mid_x - 1, mid_y + 2) = 0x12; // conveyor right
+		inventory.at(mid_x - 2, mid_y + 2) = 0x13; // conveyor left
+		inventory.at(mid_x - 1, mid_y + 3) = 0x14; // conveyor up
+		inventory.at(mid_x - 2, mid_y + 1) = 0x15; // conveyor down
+		inventory.at(mid_x - 2, mid_y) = 0x16; // sand
+		inventory.at(mid_x - 1, mid_y - 2) = 0x17; // water
 		return inventory;
 	})();
 
-	[[nodiscard]] constexpr bool chunk_exists(const sand::pos& pos) noexcept {
-		return sand::world.contains(pos.chunk_x) && sand::world[pos.chunk_x].contains(pos.chunk_y);
-	}
-
-	[[nodiscard]] constexpr sand::tile& world_at(const sand::pos& pos) noexcept {
-		return sand::world[pos.chunk_x][pos.chunk_y][pos.tile_x][pos.tile_y];
-	}
-
 	struct display_char {
 		xte::fixed_array<sand::color3, 2> pixels;
+		xte::u32 source = 0;
 
-		[[nodiscard]] friend bool operator==(const sand::display_char&, const sand::display_char&) = default;
+		[[nodiscard]] friend bool operator==(const sand::display_char& lhs, const sand::display_char& rhs) noexcept {
+			return lhs.pixels == rhs.pixels;
+		}
 	};
 
 	sand::pixel_pos screen_size = { 0, 0 };
@@ -102,19 +117,37 @@ namespace sand {
 
 	static constexpr sand::color3 shadow_color = 0x030303;
 
-	[[nodiscard]] constexpr sand::color4 texture_at(xte::u64 index, sand::pixel_pos pos) noexcept {
-		return sand::get_color(sand::texture_data[sand::textures[index].frames[sand::tick % sand::textures[index].frames_count]][pos.y * sand::texture_w + pos.x]);
+	// Zoom 0 draws textures, and each level above draws one pixel per 1, 2 or 4 tiles a side
+	// The inventory is never zoomed
+	[[nodiscard]] xte::u64 zoom_scale() noexcept {
+		return (sand::zoom && !sand::inventory_open) ? (xte::u64(1) << (sand::zoom - 1)) : 1;
 	}
 
-	[[nodiscard]] constexpr bool font_at(char index, sand::pixel_pos pos) noexcept {
-		return (pos.x < sand::font_w) && (pos.y < sand::font_h) && (sand::font_data[static_cast<xte::uz>(index)][pos.y * sand::font_w + pos.x] == '#');
+	// Anything drawn into a cell means it no longer matches a pre-encoded texture row
+	[[nodiscard]] sand::color3& screen_at(sand::pixel_pos pos) noexcept {
+		thread_local sand::color3 dummy;
+		if ((pos.x >= sand::screen_size.x) || (pos.y >= (sand::screen_size.y * 2))) {
+			return dummy;
+		}
+		auto& cell = screen[pos.y / 2 * sand::screen_size.x + pos.x];
+		cell.source = 0;
+		return cell.pixels[!!(pos.y % 2)];
 	}
 
-	[[nodiscard]] sand::color3& screen_at(sand::pixel_pos pos) noexcept {
-		static sand::color3 dummy;
-		return ((pos.x < sand::screen_size.x) && (pos.y < (sand::screen_size.y * 2)))
-			? screen[pos.y / 2 * sand::screen_size.x + pos.x].pixels[!!(pos.y % 2)]
-			: dummy;
+	struct pixel_rect {
+		sand::pixel_pos pos;
+		sand::pixel_pos size;
+	};
+
+	// Tile drawing is limited to this while part of the world layer is redrawn, and wraps like pixel positions do
+	// Each thread has its own, so workers can draw separate bands at once
+	inline constexpr sand::pixel_rect no_clip = { { 0, 0 }, { ~xte::u64(0), ~xte::u64(0) } };
+	thread_local sand::pixel_rect clip = sand::no_clip;
+
+	void draw_pixel(sand::pixel_pos pos, const sand::color3& color) noexcept {
+		if (((pos.x - sand::clip.pos.x) < sand::clip.size.x) && ((pos.y - sand::clip.pos.y) < sand::clip.size.y)) {
+			sand::screen_at(pos) = color;
+		}
 	}
 
 	constexpr sand::pixel_pos pos_to_pixel_pos(const sand::pos& pos) noexcept {
@@ -125,36 +158,169 @@ namespace sand {
 		};
 	}
 
-	constexpr void draw_texture(xte::u64 texture_index, sand::pixel_pos pixel_pos) noexcept {
+	constexpr void draw_texture(xte::u64 texture_index, sand::pixel_pos pixel_pos, xte::u8 brightness = 0xFF) noexcept {
+		const auto& frame = sand::texture_data[sand::texture_frame(texture_index, sand::tick)];
 		for (xte::u64 x = 0; x < sand::texture_w; ++x) {
 			for (xte::u64 y = 0; y < sand::texture_h; ++y) {
-				if (const auto [r, g, b, a] = sand::texture_at(texture_index, { x, y }); a) {
-					sand::screen_at({ pixel_pos.x + x, pixel_pos.y + y }) = sand::color3(r, g, b);
+				if (const auto color = sand::get_color(frame[y * sand::texture_w + x]); color.a) {
+					sand::draw_pixel({ pixel_pos.x + x, pixel_pos.y + y }, sand::shade(color, brightness));
 				}
 			}
 		}
 	}
 
-	constexpr void draw_texture_overlay(xte::u64 texture_index, xte::u64 height, sand::pixel_pos pixel_pos) noexcept {
+	constexpr void draw_texture_overlay(xte::u64 texture_index, xte::u64 height, sand::pixel_pos pixel_pos, xte::u8 brightness = 0xFF) noexcept {
+		const auto& frame = sand::texture_data[sand::texture_frame(texture_index, sand::tick)];
 		for (xte::u64 x = 0; x < sand::texture_w; ++x) {
 			for (xte::u64 y = 0; y < sand::texture_h; ++y) {
-				if (sand::texture_at(texture_index, { x, y }).a) {
-					sand::screen_at({ pixel_pos.x + x, pixel_pos.y + y - height }) = sand::shadow_color;
+				if (sand::get_color(frame[y * sand::texture_w + x]).a) {
+					sand::draw_pixel({ pixel_pos.x + x, pixel_pos.y + y - height }, sand::shadow_color);
+				}
+			}
+		}
+		sand::draw_texture(texture_index, { pixel_pos.x, pixel_pos.y - height - 1}, brightness);
+	}
+
+	constexpr void draw_tile(xte::u64 texture_index, const sand::pos& pos, xte::u8 brightness = 0xFF) noexcept {
+		sand::draw_texture(texture_index, sand::pos_to_pixel_pos(pos), brightness);
+	}
+
+	constexpr void draw_tile_overlay(xte::u64 texture_index, xte::u64 height, const sand::pos& pos, xte::u8 brightness = 0xFF) noexcept {
+		sand::draw_texture_overlay(texture_index, height, sand::pos_to_pixel_pos(pos), brightness);
+	}
+
+	// Only cells with both pixels inside the clip are tagged, since a clipped redraw leaves the rest as they were
+	void tag_cells(xte::u64 frame, xte::u8 level, sand::pixel_pos pixel_pos) noexcept {
+		if ((pixel_pos.y % 2) || !sand::frame_opaque[frame]) {
+			return;
+		}
+		for (xte::u64 row = 0; row < sand::cell_rows; ++row) {
+			const xte::u64 y = pixel_pos.y + row * 2;
+			if (((y - sand::clip.pos.y) >= sand::clip.size.y) || ((y + 1 - sand::clip.pos.y) >= sand::clip.size.y) || ((y / 2) >= sand::screen_size.y)) {
+				continue;
+			}
+			for (xte::u64 col = 0; col < sand::texture_w; ++col) {
+				const xte::u64 x = pixel_pos.x + col;
+				if (((x - sand::clip.pos.x) < sand::clip.size.x) && (x < sand::screen_size.x)) {
+					sand::screen[y / 2 * sand::screen_size.x + x].source = sand::cell_source(frame, level, row, col);
+				}
+			}
+		}
+	}
+
+	void draw_world_tile(const sand::world_chunk& chunk, const sand::pos& pos) {
+		const auto& tile = sand::tiles[chunk.tiles().at(pos.tile_x, pos.tile_y)];
+		const xte::u8 level = chunk.light_at(sand::tile_index(pos));
+		const xte::u8 brightness = sand::light_brightness(level);
+		if (tile.transparent) {
+			sand::draw_tile(0x00, pos, brightness);
+		}
+		if (tile.background) {
+			sand::draw_tile(tile.texture_index, pos, brightness);
+			if (!tile.transparent) {
+				sand::tag_cells(sand::texture_frame(tile.texture_index, sand::tick), level, sand::pos_to_pixel_pos(pos));
+			}
+		} else {
+			sand::draw_tile_overlay(tile.texture_index, 0, pos, brightness);
+		}
+		// A vertical belt shows the tile it carries in front of it
+		if (const xte::u32 carried = sand::conveyor_vertical(tile.conveyor) ? chunk.state_at(sand::tile_index(pos)) : 0; carried && (carried < sand::tiles.size())) {
+			sand::draw_tile_overlay(sand::tiles[carried].texture_index, 0, pos, brightness);
+		}
+	}
+
+	// A tile's texture reaches one pixel into the tile above and the tile below reaches into it, so all three are drawn again in order
+	void redraw_tile(const sand::pos& pos) {
+		const sand::pixel_pos pixel_pos = sand::pos_to_pixel_pos(pos);
+		sand::clip = { { pixel_pos.x, pixel_pos.y - 1 }, { sand::texture_w, sand::texture_h + 1 } };
+		for (xte::u64 y = 0; y < sand::clip.size.y; ++y) {
+			for (xte::u64 x = 0; x < sand::clip.size.x; ++x) {
+				sand::draw_pixel({ sand::clip.pos.x + x, sand::clip.pos.y + y }, sand::color3());
+			}
+		}
+		const xte::fixed_array<sand::pos, 3> column = { pos + sand::pos(0, 0, 0, 1), pos, pos - sand::pos(0, 0, 0, 1) };
+		for (auto&& tile_pos : column) {
+			if (const auto* chunk = sand::find_chunk(sand::chunk_of(tile_pos))) {
+				sand::draw_world_tile(*chunk, tile_pos);
+			}
+		}
+		sand::clip = sand::no_clip;
+	}
+
+	// Bands are whole cell rows high, so no two workers write the same terminal cell
+	inline constexpr xte::u64 band_h = sand::texture_h * 2;
+
+	// Draws every tile row of the view that reaches into the clip, top row first so each row still covers the one above
+	void draw_view_rows(const xte::fixed_array<sand::world_chunk*, 9>& view_chunks) {
+		for (xte::u64 view_chunk_y = 3; view_chunk_y--;) {
+			const xte::u64 chunk_y = sand::camera_pos.chunk_y + view_chunk_y - 1;
+			for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
+				const xte::u64 top = sand::pos_to_pixel_pos(sand::pos(sand::camera_pos.chunk_x, chunk_y, 0, tile_y)).y - 1;
+				if (((top - sand::clip.pos.y) >= sand::clip.size.y) && ((sand::clip.pos.y - top) > sand::texture_h)) {
+					continue;
+				}
+				for (xte::u64 view_chunk_x = 0; view_chunk_x < 3; ++view_chunk_x) {
+					const auto* chunk = view_chunks[view_chunk_y * 3 + view_chunk_x];
+					const xte::u64 chunk_x = sand::camera_pos.chunk_x + view_chunk_x - 1;
+					for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+						sand::draw_world_tile(*chunk, sand::pos(chunk_x, chunk_y, tile_x, tile_y));
+					}
 				}
 			}
 		}
-		sand::draw_texture(texture_index, { pixel_pos.x, pixel_pos.y - height - 1});
 	}
 
-	constexpr void draw_tile(xte::u64 texture_index, const sand::pos& pos) noexcept {
-		sand::draw_texture(texture_index, sand::pos_to_pixel_pos(pos));
+	// Splits the screen into bands drawn on the worker pool, each clipped to its own rows
+	// A tile whose shadow or texture crosses a band edge is drawn by both bands, each keeping only its own part
+	void draw_view(const xte::fixed_array<sand::world_chunk*, 9>& view_chunks) {
+		// Frozen chunks are unpacked here first, so workers only ever read them
+		for (const auto* chunk : view_chunks) {
+			chunk->thaw();
+		}
+		const xte::u64 bands = (sand::screen_size.y * 2 + sand::band_h - 1) / sand::band_h;
+		sand::workers.parallel_for(bands, [&](xte::uz band) -> void {
+			sand::clip = { { 0, band * sand::band_h }, { ~xte::u64(0), sand::band_h } };
+			sand::draw_view_rows(view_chunks);
+			sand::clip = sand::no_clip;
+		});
 	}
 
-	constexpr void draw_tile_overlay(xte::u64 texture_index, xte::u64 height, const sand::pos& pos) noexcept {
-		sand::draw_texture_overlay(texture_index, height, sand::pos_to_pixel_pos(pos));
+	// What the world layer was last drawn from, so a frame with the same view only redraws what changed
+	struct world_view {
+		sand::pos camera;
+		sand::pixel_pos size;
+		bool inventory;
+		xte::u64 zoom;
+
+		[[nodiscard]] friend constexpr bool operator==(const sand::world_view&, const sand::world_view&) noexcept = default;
+	};
+
+	xte::array<sand::display_char> world_layer;
+	sand::world_view drawn_view = { { 0, 0, 0, 0 }, { 0, 0 }, false, 0 };
+	xte::u64 drawn_tick = 0;
+	bool redraw_all = true;
+	std::vector<sand::pos> redraw_tiles;
+
+	// Runs before the change queue is cleared, so the next frame knows what to draw again
+	void queue_redraws() {
+		for (auto&& change : sand::tile_changes) {
+			sand::redraw_tiles.push_back(change.pos);
+		}
+		sand::redraw_tiles.insert(sand::redraw_tiles.end(), sand::light_changes.begin(), sand::light_changes.end());
+		sand::redraw_tiles.insert(sand::redraw_tiles.end(), sand::carry_changes.begin(), sand::carry_changes.end());
+		if (!sand::inserted_chunks.empty()) {
+			sand::redraw_all = true;
+		}
 	}
 
-	constexpr void write_text(xte::string_view text, const sand::color3& color, sand::pixel_pos pos) noexcept {
+	struct text_pixel {
+		sand::pixel_pos pos;
+		sand::color3 color;
+	};
+
+	// Pixels are kept in drawing order, so a shadow is still covered by a lit pixel below it
+	[[nodiscard]] std::vector<sand::text_pixel> rasterize_text(xte::string_view text, const sand::color3& color) {
+		std::vector<sand::text_pixel> pixels;
 		xte::u64 row = 0;
 		xte::u64 col = 0;
 		for (char c : text) {
@@ -163,34 +329,139 @@ namespace sand {
 				col = 0;
 				continue;
 			}
-			for (xte::u64 x = 0; x < sand::font_w; ++x) {
-				for (xte::u64 y = 0; y < sand::font_h; ++y) {
-					if (sand::font_at(c, { x, y })) {
-						const xte::u64 pixel_x = pos.x + col * sand::font_w + x;
-						const xte::u64 pixel_y = pos.y + row * sand::font_h + y;
-						screen_at({ pixel_x, pixel_y }) = color;
-						screen_at({ pixel_x, pixel_y + 1 }) = sand::shadow_color;
-					}
+			const xte::u32 mask = sand::font_masks[static_cast<xte::u8>(c)];
+			for (xte::u64 y = 0; y < sand::font_h; ++y) {
+				for (xte::u32 bits = (mask >> (y * sand::font_w)) & ((xte::u32(1) << sand::font_w) - 1); bits; bits &= bits - 1) {
+					const xte::u64 pixel_x = col * sand::font_w + static_cast<xte::u64>(std::countr_zero(bits));
+					const xte::u64 pixel_y = row * sand::font_h + y;
+					pixels.push_back({ { pixel_x, pixel_y }, color });
+					pixels.push_back({ { pixel_x, pixel_y + 1 }, sand::shadow_color });
 				}
 			}
 			++col;
 		}
+		return pixels;
+	}
+
+	// Remembers the values its text was formatted from, and is only formatted and rasterized again when they change
+	struct text_layer {
+		std::vector<xte::u64> key;
+		std::vector<sand::text_pixel> pixels;
+		bool drawn = false;
+	};
+
+	void draw_text_layer(sand::text_layer& layer, std::vector<xte::u64> key, const std::function<std::string()>& text, const sand::color3& color, sand::pixel_pos pos) {
+		if (!layer.drawn || (layer.key != key)) {
+			layer.key = std::move(key);
+			layer.pixels = sand::rasterize_text(text(), color);
+			layer.drawn = true;
+		}
+		for (auto&& pixel : layer.pixels) {
+			sand::screen_at({ pos.x + pixel.pos.x, pos.y + pixel.pos.y }) = pixel.color;
+		}
+	}
+
+	// Reads tile colors and chunk summaries instead of textures, and leaves chunks that were never saved black
+	void draw_zoomed(xte::u64 scale) {
+		const xte::u64 cells_w = sand::chunk_w / scale;
+		const xte::u64 cells_h = sand::chunk_h / scale;
+		const xte::u64 width = sand::screen_size.x;
+		const xte::u64 height = sand::screen_size.y * 2;
+		const xte::u64 reach_x = width / 2 / cells_w + 1;
+		const xte::u64 reach_y = height / 2 / cells_h + 1;
+		std::vector<sand::chunk_pos> visible;
+		for (xte::u64 view_chunk_y = 0; view_chunk_y <= (reach_y * 2); ++view_chunk_y) {
+			for (xte::u64 view_chunk_x = 0; view_chunk_x <= (reach_x * 2); ++view_chunk_x) {
+				visible.push_back({ sand::camera_pos.chunk_x + view_chunk_x - reach_x, sand::camera_pos.chunk_y + view_chunk_y - reach_y });
+			}
+		}
+		sand::load_chunks(visible);
+		for (auto&& pos : visible) {
+			auto* chunk = sand::load_chunk(pos);
+			if (!chunk) {
+				continue;
+			}
+			const xte::u64 origin_x = width / 2 + (pos.x - sand::camera_pos.chunk_x) * cells_w - sand::camera_pos.tile_x / scale;
+			const xte::u64 origin_y = height / 2 - (pos.y - sand::camera_pos.chunk_y) * cells_h + sand::camera_pos.tile_y / scale;
+			for (xte::u64 cell_y = 0; cell_y < cells_h; ++cell_y) {
+				for (xte::u64 cell_x = 0; cell_x < cells_w; ++cell_x) {
+					sand::screen_at({ origin_x + cell_x, origin_y - cell_y }) = (scale == 1)
+						? sand::tile_colors[chunk->tiles().at(cell_x, cell_y)]
+						: chunk->summary().at(scale, cell_x, cell_y);
+				}
+			}
+		}
+		sand::screen_at({ width / 2, height / 2 }) = 0xFFFFFF;
 	}
 
-	static constexpr xte::string_view save_dir = "save";
+	inline constexpr xte::u64 encode_band_h = 0x10;
+
+	// Reads and writes nothing outside its own row, so rows can be encoded on separate threads and joined in order
+	void encode_row(std::string& out, xte::u64 pixel_y, const xte::array<sand::display_char>& previous, bool skippable) {
+		for (xte::u64 pixel_x = 0; pixel_x < sand::screen_size.x;) {
+			const xte::u64 pixel_index = pixel_y * sand::screen_size.x + pixel_x;
+			if (skippable && (sand::screen[pixel_index] == previous[pixel_index])) {
+				++pixel_x;
+				continue;
+			}
+			std::format_to(std::back_inserter(out), "\x1B[{};{}H", pixel_y + 1, pixel_x + 1);
+			// Changed cells that follow on along one texture row are spliced in from its pre-encoded bytes under a single cursor move
+			if (const xte::u32 source = sand::screen[pixel_index].source) {
+				xte::u64 count = 1;
+				while (
+					((pixel_x + count) < sand::screen_size.x)
+					&& (sand::screen[pixel_index + count].source == (source + count))
+					&& !(skippable && (sand::screen[pixel_index + count] == previous[pixel_index + count]))
+				) {
+					++count;
+				}
+				sand::encode_cells(out, source, count);
+				pixel_x += count;
+				continue;
+			}
+			sand::encode_cell(out, sand::screen[pixel_index].pixels[0], sand::screen[pixel_index].pixels[1]);
+			++pixel_x;
+		}
+	}
 
-	constexpr void log(xte::string_view message) noexcept {
-		std::println("{}\r", message);
+	// Gathers the rows into as few writes as `IOV_MAX` allows, picking up partway through a row after a short write
+	void write_rows(const std::vector<std::string>& rows) {
+		std::vector<::iovec> pending;
+		for (auto&& row : rows) {
+			if (!row.empty()) {
+				pending.push_back({ const_cast<char*>(row.data()), row.size() });
+			}
+		}
 		std::fflush(stdout);
+		for (xte::uz i = 0; i < pending.size();) {
+			const ::ssize_t written = ::writev(STDOUT_FILENO, pending.data() + i, static_cast<int>(std::min<xte::uz>(pending.size() - i, IOV_MAX)));
+			if (written < 0) {
+				sand::log("failed to write to the terminal");
+				throw;
+			}
+			for (auto left = static_cast<xte::uz>(written); left;) {
+				const xte::uz step = std::min(left, pending[i].iov_len);
+				pending[i].iov_base = static_cast<char*>(pending[i].iov_base) + step;
+				pending[i].iov_len -= step;
+				left -= step;
+				if (!pending[i].iov_len) {
+					++i;
+				}
+			}
+		}
 	}
 
-	[[nodiscard]] constexpr xte::u64 tile_index(const sand::tile& tile) noexcept {
-		for (xte::u64 i = 0; i < sand::tiles.size(); ++i) {
-			if (sand::tiles[i] == tile) {
-				return i;
+	// Copies the cached map into the top right corner, with the camera's chunk in white
+	void draw_minimap() {
+		const sand::chunk_pos center = sand::chunk_of(sand::camera_pos);
+		sand::scroll_minimap(center);
+		const xte::u64 left = sand::screen_size.x - sand::minimap_size - 1;
+		for (xte::u64 y = 0; y < sand::minimap_size; ++y) {
+			for (xte::u64 x = 0; x < sand::minimap_size; ++x) {
+				const sand::chunk_pos pos = { center.x + x - sand::minimap_size / 2, center.y + y - sand::minimap_size / 2 };
+				sand::screen_at({ left + x, sand::minimap_size - y }) = (pos == center) ? sand::color3(0xFFFFFF) : sand::minimap_at(pos).color;
 			}
 		}
-		std::unreachable();
 	}
 }
 
@@ -210,62 +481,132 @@ int main() {
 	}
 	std::print("\x1B[?47h\x1B[s\x1B[?25l\x1B[2J\x1B[3J\x1B[0m");
 
+	if (const char* chunk_budget = std::getenv("SAND_CHUNK_BUDGET")) {
+		auto [number, length] = xte::parse_number<xte::u64>.with_index(xte::string_view(chunk_budget), 10);
+		if (!length) {
+			sand::log("invalid SAND_CHUNK_BUDGET");
+			throw;
+		}
+		sand::chunk_budget = std::max<xte::u64>(number, 9);
+	}
+	// Every edit up to and including the saved tick is already in the chunk files, so play resumes on the tick after it
+	bool checkpointed = false;
+	xte::u64 checkpoint_tick = 0;
+	xte::u64 covered_tick = 0;
+	sand::store_mode saved_store = std::filesystem::exists(sand::world_file_path()) ? sand::store_mode::mapped : sand::store_mode::files;
 	if (std::filesystem::exists(std::format("{}/index.txt", sand::save_dir))) {
 		const xte::string data = xte::file(std::format("{}/index.txt", sand::save_dir), xte::file_mode::read).read();
 		xte::uz i = 0;
-
-		auto parse = [&](xte::string_view data) -> xte::u64 {
-			while (xte::is_whitespace(data[i])) {
-				++i;
-			}
-			auto [number, length] = xte::parse_number<xte::u64>.with_index(data.subview(i), 16);
-			if (!length) {
-				sand::log("failed to parse save data");
+		checkpoint_tick = sand::parse_hex(data, i);
+		checkpointed = true;
+		covered_tick = checkpoint_tick;
+		sand::camera_pos = { sand::parse_hex(data, i), sand::parse_hex(data, i), sand::parse_hex(data, i), sand::parse_hex(data, i) };
+		while ((i < data.size()) && xte::is_whitespace(data[i])) {
+			++i;
+		}
+		if (i < data.size()) {
+			const xte::u64 mode = sand::parse_hex(data, i);
+			if (mode > static_cast<xte::u64>(sand::store_mode::mapped)) {
+				sand::log("invalid store mode in save index");
 				throw;
 			}
-			i += length;
-			return number;
-		};
+			saved_store = static_cast<sand::store_mode>(mode);
+		}
+	}
 
-		sand::tick = parse(data);
-		sand::camera_pos = { parse(data), parse(data), parse(data), parse(data) };
-
-		if (std::filesystem::exists(std::format("{}/chunks", sand::save_dir))) {
-			for (const auto& chunk_file : std::filesystem::directory_iterator(std::format("{}/chunks", sand::save_dir))) {
-				i = 0;
-				const xte::u64 chunk_x = parse(xte::string_view(chunk_file.path().filename().c_str()));
-				const xte::u64 chunk_y = parse(xte::string_view(chunk_file.path().filename().c_str()));
-				i = 0;
-				const xte::string data = xte::file(xte::string_view(chunk_file.path().c_str()), xte::file_mode::read).read();
-				for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
-					for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
-						auto a = parse(data);
-						if (a >= sand::tiles.size()) {sand::log(std::format("out of bounds: {}", a));return 1;}
-						sand::world[chunk_x][chunk_y][tile_x][tile_y] = sand::tiles[a];
-					}
-				}
+	// Text chunks are imported into a new world file on demand, but there is no way back, and two live copies must never be mixed
+	if (const char* store = std::getenv("SAND_STORE"); store && (xte::string_view(store) == "mapped")) {
+		sand::store = sand::store_mode::mapped;
+	}
+	if ((sand::store != saved_store) && ((saved_store == sand::store_mode::mapped) || std::filesystem::exists(sand::world_file_path()))) {
+		sand::log((saved_store == sand::store_mode::mapped) ? "this save needs SAND_STORE=mapped" : "this save was last written without SAND_STORE=mapped");
+		throw;
+	}
+	if (sand::store == sand::store_mode::mapped) {
+		sand::open_world_file();
+	}
+
+	auto rng = std::mt19937(std::random_device()());
+
+	const std::vector<std::string> journal_segments = sand::journal_segments();
+	std::vector<std::vector<sand::journal_record>> journal;
+	std::vector<sand::chunk_pos> journal_chunks;
+	// Segments whose removal was cut short by a crash still hold edits the checkpoint covers, and replaying them would undo later simulation
+	for (auto&& path : journal_segments) {
+		auto& records = journal.emplace_back(sand::read_journal(path));
+		std::erase_if(records, [&](const sand::journal_record& record) -> bool {
+			return checkpointed && (record.tick <= checkpoint_tick);
+		});
+		for (auto&& record : records) {
+			journal_chunks.push_back(sand::chunk_of(record.pos));
+		}
+	}
+	sand::load_chunks(journal_chunks);
+	// A chunk written back by eviction, by a save whose index never landed, or by the kernel for a mapped page already holds the edits up to its own tick
+	for (auto&& records : journal) {
+		for (auto&& record : records) {
+			auto* chunk = sand::load_chunk(sand::chunk_of(record.pos));
+			if (!chunk) {
+				chunk = &sand::generate_chunk(sand::chunk_of(record.pos), rng);
+			}
+			if (record.tick > chunk->stored_tick) {
+				sand::tick = record.tick;
+				sand::set_tile(*chunk, record.pos, record.new_id);
 			}
+			covered_tick = std::max(covered_tick, record.tick);
 		}
 	}
+	sand::tick = covered_tick + 1;
+	sand::open_journal(journal_segments.empty() ? 1 : (sand::journal_segment_of(journal_segments.back()) + 1));
 
-	auto rng = std::mt19937(std::random_device()());
+	sand::start_saver();
+	if (!journal_segments.empty()) {
+		sand::save_world(covered_tick, sand::format_index(covered_tick, sand::camera_pos), journal_segments);
+	}
 
 	sand::pixel_pos previous_screen_size = { 0, 0 };
 	xte::array<sand::display_char> previous_screen;
+	std::vector<std::string> output_rows;
+	sand::text_layer tick_layer;
+	sand::text_layer position_layer;
+	sand::text_layer info_layer;
 	bool placed = false;
 	for (;; ++sand::tick) {
 		::winsize screen_size;
 		::ioctl(::fileno(stdin), TIOCGWINSZ, &screen_size);
 		sand::screen_size = { screen_size.ws_col, screen_size.ws_row };
 
-		sand::screen.reset();
-		sand::screen.resize(sand::screen_size.x * sand::screen_size.y);
+		const sand::world_view view = { sand::inventory_open ? sand::select_pos : sand::camera_pos, sand::screen_size, sand::inventory_open, sand::zoom };
+		bool full_redraw = sand::redraw_all || sand::inventory_open || sand::zoom || (view != sand::drawn_view);
+		xte::fixed_array<sand::world_chunk*, 9> view_chunks = {};
+		if (!sand::inventory_open && !sand::zoom) {
+			xte::fixed_array<sand::chunk_pos, 9> view_positions;
+			for (xte::u64 i = 0; i < view_positions.size(); ++i) {
+				view_positions[i] = { sand::camera_pos.chunk_x + i % 3 - 1, sand::camera_pos.chunk_y + i / 3 - 1 };
+			}
+			const xte::uz inserted = sand::inserted_chunks.size();
+			sand::load_chunks(view_positions);
+			for (xte::u64 i = 0; i < view_chunks.size(); ++i) {
+				view_chunks[i] = sand::load_chunk(view_positions[i]);
+				if (!view_chunks[i]) {
+					view_chunks[i] = &sand::generate_chunk(view_positions[i], rng);
+				}
+			}
+			full_redraw = full_redraw || (sand::inserted_chunks.size() != inserted);
+		}
+
+		if (full_redraw) {
+			sand::screen.reset();
+			sand::screen.resize(sand::screen_size.x * sand::screen_size.y);
+		} else {
+			sand::screen = sand::world_layer;
+		}
 
 		if (sand::inventory_open) {
 			for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
 				for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
 					auto pos = sand::pos(0, 0, tile_x, tile_y);
-					const auto& tile = sand::inventory[tile_x][tile_y];
+					const auto& tile = sand::tiles[sand::inventory.at(tile_x, tile_y)];
 					if (tile.transparent) {
 						sand::draw_tile(0x00, pos);
 					}
@@ -276,56 +617,37 @@ int main() {
 					}
 				}
 			}
+		} else if (sand::zoom) {
+			sand::draw_zoomed(sand::zoom_scale());
+		} else if (full_redraw) {
+			sand::draw_view(view_chunks);
 		} else {
-			for (xte::u64 view_chunk_y = 3; view_chunk_y--;) {
-				for (xte::u64 view_chunk_x = 0; view_chunk_x < 3; ++view_chunk_x) {
-					const xte::u64 chunk_x = sand::camera_pos.chunk_x + view_chunk_x - 1;
-					const xte::u64 chunk_y = sand::camera_pos.chunk_y + view_chunk_y - 1;
-					if (!sand::world.contains(chunk_x) || !sand::world[chunk_x].contains(chunk_y)) {
-						auto& chunk = sand::world[chunk_x][chunk_y];
-						if (std::uniform_int_distribution<xte::u64>(0, 63)(rng)) {
-							for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
-								for (xte::u64 tile_y = 0; tile_y < sand::chunk_h; ++tile_y) {
-									auto& tile = chunk[tile_x][tile_y];
-									bool left_empty = tile_x ? !chunk[tile_x - 1][tile_y].texture_index : (sand::world.contains(chunk_x - 1) && sand::world[chunk_x - 1].contains(chunk_y)) ? !sand::world[chunk_x - 1][chunk_y][sand::chunk_w - 1][tile_y].texture_index : false;
-									bool right_empty = (tile_x < (sand::chunk_w - 1)) ? !chunk[tile_x + 1][tile_y].texture_index : (sand::world.contains(chunk_x + 1) && sand::world[chunk_x + 1].contains(chunk_y)) ? !sand::world[chunk_x + 1][chunk_y][0][tile_y].texture_index : false;
-									bool down_empty = tile_y ? !chunk[tile_x][tile_y - 1].texture_index : (sand::world.contains(chunk_x) && sand::world[chunk_x].contains(chunk_y - 1)) ? !sand::world[chunk_x][chunk_y - 1][tile_x][sand::chunk_h - 1].texture_index : false;
-									bool up_empty = (tile_y < (sand::chunk_h - 1)) ? !chunk[tile_x][tile_y + 1].texture_index : (sand::world.contains(chunk_x) && sand::world[chunk_x].contains(chunk_y + 1)) ? !sand::world[chunk_x][chunk_y + 1][tile_x][0].texture_index : false;
-									if (xte::less(std::uniform_int_distribution<xte::u64>(0, 5)(rng), (left_empty + right_empty + down_empty + up_empty)) || !std::uniform_int_distribution<xte::u64>(0, 63)(rng)) {
-										tile = sand::tiles[0x00];
-									} else {
-										tile = sand::tiles[std::bernoulli_distribution()(rng) ? 0x02 : 0x07];
-									}
-								}
-							}
-						} else {
-							for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
-								for (xte::u64 tile_y = 0; tile_y < sand::chunk_h; ++tile_y) {
-									chunk[tile_x][tile_y] = sand::tiles[std::uniform_int_distribution<xte::u64>(0, sand::tiles.size() - 1)(rng)];
-								}
-							}
-						}
-					}
-					for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
-						for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
-							auto pos = sand::pos(chunk_x, chunk_y, tile_x, tile_y);
-							const auto& tile = sand::world_at(pos);
-							if (tile.transparent) {
-								sand::draw_tile(0x00, pos);
-							}
-							if (tile.background) {
-								sand::draw_tile(tile.texture_index, pos);
-							} else {
-								sand::draw_tile_overlay(tile.texture_index, 0, pos);
-							}
-						}
+			// Only changed tiles and animated tiles whose frame moved on are drawn again
+			for (auto&& pos : sand::redraw_tiles) {
+				if (((pos.chunk_x - sand::camera_pos.chunk_x + 1) < 3) && ((pos.chunk_y - sand::camera_pos.chunk_y + 1) < 3)) {
+					sand::redraw_tile(pos);
+				}
+			}
+			for (xte::u64 i = 0; i < view_chunks.size(); ++i) {
+				const auto* chunk = view_chunks[i];
+				sand::tile_mask animated = chunk->animated;
+				xte::uz index;
+				while (animated.take(index)) {
+					const sand::pos pos = sand::pos(sand::camera_pos.chunk_x + i % 3 - 1, sand::camera_pos.chunk_y + i / 3 - 1, index % sand::chunk_w, index / sand::chunk_w);
+					if (sand::frame_changed(sand::tiles[chunk->tiles().at(pos.tile_x, pos.tile_y)].texture_index, sand::drawn_tick, sand::tick)) {
+						sand::redraw_tile(pos);
 					}
 				}
 			}
 		}
+		sand::world_layer = sand::screen;
+		sand::drawn_view = view;
+		sand::drawn_tick = sand::tick;
+		sand::redraw_all = false;
+		sand::redraw_tiles.clear();
 
 		auto& camera_pos = sand::inventory_open ? sand::select_pos : sand::camera_pos;
-		if (sand::inventory_open || ((sand::select != sand::tiles[0x00]) && !placed)) {
+		if (sand::inventory_open || (!sand::zoom && (sand::select != 0x00) && !placed)) {
 			sand::draw_tile_overlay(0x0E, 1, camera_pos - sand::pos(0, 0, 1, 0) + sand::pos(0, 0, 0, 1)); // top left corner
 			sand::draw_tile_overlay(0x0F, 1, camera_pos + sand::pos(0, 0, 0, 1)); // top left horizontal
 			sand::draw_tile_overlay(0x10, 1, camera_pos - sand::pos(0, 0, 1, 0)); // top left vertical
@@ -333,7 +655,7 @@ int main() {
 			sand::draw_tile_overlay(0x12, 1, camera_pos + sand::pos(0, 0, 0, 1)); // top right horizontal
 			sand::draw_tile_overlay(0x13, 1, camera_pos + sand::pos(0, 0, 1, 0)); // top right vertical
 			if (!sand::inventory_open) {
-				sand::draw_tile_overlay(sand::select.texture_index, 1, camera_pos);
+				sand::draw_tile_overlay(sand::tiles[sand::select].texture_index, 1, camera_pos);
 			}
 			sand::draw_tile_overlay(0x16, 1, camera_pos - sand::pos(0, 0, 1, 0)); // bottom left vertical
 			sand::draw_tile_overlay(0x15, 1, camera_pos - sand::pos(0, 0, 0, 1)); // bottom left horizontal
@@ -341,7 +663,7 @@ int main() {
 			sand::draw_tile_overlay(0x19, 1, camera_pos + sand::pos(0, 0, 1, 0)); // bottom right vertical
 			sand::draw_tile_overlay(0x18, 1, camera_pos - sand::pos(0, 0, 0, 1)); // bottom right horizontal
 			sand::draw_tile_overlay(0x17, 1, camera_pos + sand::pos(0, 0, 1, 0) - sand::pos(0, 0, 0, 1)); // bottom right corner
-		} else {
+		} else if (!sand::zoom) {
 			sand::draw_tile_overlay(0x0E, 1, camera_pos); // top left corner
 			sand::draw_tile_overlay(0x0F, 1, camera_pos + sand::pos(0, 0, 1, 0)); // top left horizontal
 			sand::draw_tile_overlay(0x10, 1, camera_pos - sand::pos(0, 0, 0, 1)); // top left vertical
@@ -356,54 +678,78 @@ int main() {
 			sand::draw_tile_overlay(0x17, 1, camera_pos); //bottom right corner
 		}
 
-		sand::write_text(std::format(
-			"tick: {:X}\n"
-			"X:    {:X}\n"
-			"Y:    {:X}\n"
-			"x:    {:X}\n"
-			"y:    {:X}",
-			sand::tick,
-			static_cast<xte::i64>(camera_pos.chunk_x),
-			static_cast<xte::i64>(camera_pos.chunk_y),
-			camera_pos.tile_x,
-			camera_pos.tile_y
-		), 0xFFFFFF, { 1, 1 });
-
-		std::string display;
+		if (sand::minimap_open && !sand::inventory_open) {
+			sand::draw_minimap();
+		}
+
+		// The tick changes every frame, so it is kept apart from the lines that rarely do
+		sand::draw_text_layer(tick_layer, { sand::tick }, [&] -> std::string {
+			return std::format("tick: {:X}", sand::tick);
+		}, 0xFFFFFF, { 1, 1 });
+		sand::draw_text_layer(position_layer, { camera_pos.chunk_x, camera_pos.chunk_y, camera_pos.tile_x, camera_pos.tile_y }, [&] -> std::string {
+			return std::format(
+				"X:    {:X}\n"
+				"Y:    {:X}\n"
+				"x:    {:X}\n"
+				"y:    {:X}",
+				static_cast<xte::i64>(camera_pos.chunk_x),
+				static_cast<xte::i64>(camera_pos.chunk_y),
+				camera_pos.tile_x,
+				camera_pos.tile_y
+			);
+		}, 0xFFFFFF, { 1, 1 + sand::font_h });
+		if (sand::info_open) {
+			const sand::world_memory memory = sand::measure_world();
+			const xte::u64 selected_count = sand::count_region(sand::pos(camera_pos.chunk_x - 1, camera_pos.chunk_y - 1, 0, 0), sand::pos(camera_pos.chunk_x + 1, camera_pos.chunk_y + 1, sand::chunk_w - 1, sand::chunk_h - 1), sand::select);
+			sand::draw_text_layer(info_layer, { memory.hot_chunks, memory.cold_chunks, memory.cold_bytes, memory.shared_chunks, memory.shared_bytes, selected_count }, [&] -> std::string {
+				return std::format(
+					"hot:    {:X} {:X}K\n"
+					"cold:   {:X} {:X}K\n"
+					"shared: {:X} {:X}K\n"
+					"select: {:X}",
+					memory.hot_chunks,
+					memory.hot_chunks * sizeof(sand::chunk) / 0x400,
+					memory.cold_chunks,
+					memory.cold_bytes / 0x400,
+					memory.shared_chunks,
+					memory.shared_bytes / 0x400,
+					selected_count
+				);
+			}, 0xFFFFFF, { 1, 1 + sand::font_h * 6 });
+		}
+
 		if (sand::screen != previous_screen) {
 			const bool skippable = sand::screen_size == previous_screen_size;
 			previous_screen.resize(sand::screen.size());
-			for (xte::u64 pixel_y = 0; pixel_y < sand::screen_size.y; ++pixel_y) {
-				for (xte::u64 pixel_x = 0; pixel_x < sand::screen_size.x; ++pixel_x) {
-					const xte::u64 pixel_index = pixel_y * sand::screen_size.x + pixel_x;
-					if (skippable && (sand::screen[pixel_index] == previous_screen[pixel_index])) {
-						continue;
-					}
-					std::format_to(
-						std::back_inserter(display),
-						"\x1B[{};{}H\x1B[38;2;{};{};{}m\x1B[48;2;{};{};{}m▀",
-						pixel_y + 1,
-						pixel_x + 1,
-						sand::screen[pixel_index].pixels[0].r,
-						sand::screen[pixel_index].pixels[0].g,
-						sand::screen[pixel_index].pixels[0].b,
-						sand::screen[pixel_index].pixels[1].r,
-						sand::screen[pixel_index].pixels[1].g,
-						sand::screen[pixel_index].pixels[1].b
-					);
+			output_rows.resize(sand::screen_size.y);
+			const xte::u64 bands = (sand::screen_size.y + sand::encode_band_h - 1) / sand::encode_band_h;
+			sand::workers.parallel_for(bands, [&](xte::uz band) -> void {
+				for (xte::u64 pixel_y = band * sand::encode_band_h; pixel_y < std::min((band + 1) * sand::encode_band_h, sand::screen_size.y); ++pixel_y) {
+					output_rows[pixel_y].clear();
+					sand::encode_row(output_rows[pixel_y], pixel_y, previous_screen, skippable);
 				}
-			}
+			});
+			sand::write_rows(output_rows);
 			previous_screen = sand::screen;
 		}
 
-		std::print("{}", display);
-		std::fflush(stdout);
-
 		std::this_thread::sleep_for(1000ms / 20);
 
 		placed = false;
 		::fcntl(STDIN_FILENO, F_SETFL, terminal_blocking | O_NONBLOCK);
-		auto& selected_tile = sand::world_at(sand::camera_pos);
+		const sand::tile_id* selected = sand::find_tile(sand::camera_pos);
+		sand::tile_id selected_tile = selected ? *selected : 0x00;
+		// Nothing is placed while zoomed out, since there is no cursor and the camera may be over ungenerated chunks
+		// A removed belt leaves what it carried, so the tile actually written is read back for the journal
+		auto place = [&](sand::tile_id tile) -> bool {
+			if (sand::zoom || !sand::set_tile(sand::camera_pos, tile)) {
+				return false;
+			}
+			const sand::tile_id written = *sand::find_tile(sand::camera_pos);
+			sand::journal_edit({ sand::camera_pos, selected_tile, written, sand::tick });
+			selected_tile = written;
+			return true;
+		};
 		if (([&] -> bool {
 			while (true) {
 				switch (std::fgetc(stdin)) {
@@ -412,40 +758,38 @@ int main() {
 				case '\\':
 				case 'R':
 				case 'r':
-					selected_tile = sand::select;
-					placed = true;
+					placed = place(sand::select);
 					break;
 				case '\r':
 				case ' ':
 					if (sand::inventory_open) {
-						sand::select = sand::inventory[sand::select_pos.tile_x][sand::select_pos.tile_y];
+						sand::select = sand::inventory.at(sand::select_pos.tile_x, sand::select_pos.tile_y);
 						sand::inventory_open = false;
-					} else {
-						sand::tile select_copy = sand::select;
-						if (!selected_tile.background || (sand::select == sand::tiles[0x00])) {
-							sand::select = selected_tile;
-						} else {
-							sand::select = sand::tiles[0x00];
+					} else if (!sand::zoom) {
+						// The selection only changes hands if the placement went through
+						const sand::tile_id picked = selected_tile;
+						const sand::tile_id select_copy = sand::select;
+						if (place(select_copy)) {
+							sand::select = (!sand::tiles[picked].background || (select_copy == 0x00)) ? picked : 0x00;
+							placed = select_copy != 0x00;
 						}
-						selected_tile = select_copy;
-						placed = select_copy != sand::tiles[0x00];
 					}
 					break;
 				case 'D':
 				case 'd':
-					camera_pos += sand::pos(0, 0, 1, 0);
+					camera_pos += sand::pos(0, 0, sand::zoom_scale(), 0);
 					break;
 				case 'A':
 				case 'a':
-					camera_pos -= sand::pos(0, 0, 1, 0);
+					camera_pos -= sand::pos(0, 0, sand::zoom_scale(), 0);
 					break;
 				case 'W':
 				case 'w':
-					camera_pos += sand::pos(0, 0, 0, 1);
+					camera_pos += sand::pos(0, 0, 0, sand::zoom_scale());
 					break;
 				case 'S':
 				case 's':
-					camera_pos -= sand::pos(0, 0, 0, 1);
+					camera_pos -= sand::pos(0, 0, 0, sand::zoom_scale());
 					break;
 				case 'E':
 				case 'e':
@@ -455,12 +799,24 @@ int main() {
 						sand::inventory_open = true;
 					}
 					break;
+				case 'I':
+				case 'i':
+					sand::info_open = !sand::info_open;
+					break;
+				case 'M':
+				case 'm':
+					sand::minimap_open = !sand::minimap_open;
+					break;
+				case 'Z':
+				case 'z':
+					sand::zoom = (sand::zoom + 1) % 4;
+					break;
 				case 'Q':
 				case 'q':
-					if (sand::select == sand::tiles[0x00]) {
+					if (sand::select == 0x00) {
 						sand::select = selected_tile;
 					} else {
-						sand::select = sand::tiles[0x00];
+						sand::select = 0x00;
 					}
 					sand::inventory_open = false;
 					break;
@@ -473,55 +829,32 @@ int main() {
 			break;
 		}
 		::fcntl(STDIN_FILENO, F_SETFL, terminal_blocking);
+
+		sand::sync_journal();
+		sand::step_world();
+		sand::update_light();
+		sand::update_occupancy();
+		sand::update_minimap();
+		sand::queue_redraws();
+		sand::clear_tile_changes();
+		sand::evict_chunks();
+		if (!(sand::tick % sand::freeze_interval)) {
+			sand::freeze_chunks();
+		}
+		if (!(sand::tick % sand::autosave_interval) || sand::journal_full()) {
+			sand::save_world(sand::tick, sand::format_index(sand::tick, sand::camera_pos), sand::rotate_journal());
+		}
 	}
 
 	std::print("\x1B[0m\x1B[?25h\x1B[u\x1B[?47l");
 	::tcsetattr(STDIN_FILENO, TCSANOW, &terminal_cooked);
 	::fcntl(STDIN_FILENO, F_SETFL, terminal_blocking);
 
-	{
-		std::filesystem::create_directory(std::format("{}", sand::save_dir));
-		auto index_file = xte::file(std::format("{}/index.txt", sand::save_dir), xte::file_mode::overwrite);
-		if (!index_file) {
-			sand::log("failed to write index");
-			throw;
-		}
-		std::println(
-			index_file,
-			"{:X} {:X} {:X} {:X} {:X}",
-			sand::tick,
-			sand::camera_pos.chunk_x,
-			sand::camera_pos.chunk_y,
-			sand::camera_pos.tile_x,
-			sand::camera_pos.tile_y
-		);
-		for (auto&& [chunk_x, chunks_column] : sand::world) {
-			for (auto&& [chunk_y, chunk] : chunks_column) {
-				if (([&] -> bool {
-					for (auto&& tiles_column : chunk) {
-						for (auto&& tile : tiles_column) {
-							if (tile != sand::tiles[0]) {
-								return false;
-							}
-						}
-					}
-					return true;
-				})()) {
-					continue;
-				}
-				std::filesystem::create_directory(std::format("{}/chunks", sand::save_dir));
-				auto chunk_file = xte::file(std::format("{}/chunks/{:0>16X} {:0>16X}.txt", sand::save_dir, chunk_x, chunk_y), xte::file_mode::overwrite);
-				if (!chunk_file) {
-					sand::log(std::format("failed to write chunk {} {}", static_cast<xte::i64>(chunk_x), static_cast<xte::i64>(chunk_y)));
-					throw;
-				}
-				for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
-					for (xte::u64 tile_x = 0; tile_x < (sand::chunk_w - 1); ++tile_x) {
-						std::print(chunk_file, "{:0>2X} ", tile_index(sand::world[chunk_x][chunk_y][tile_x][tile_y]));
-					}
-					std::println(chunk_file, "{:0>2X}", tile_index(sand::world[chunk_x][chunk_y][sand::chunk_w - 1][tile_y]));
-				}
-			}
-		}
+	sand::save_world(sand::tick, sand::format_index(sand::tick, sand::camera_pos), sand::rotate_journal());
+	sand::stop_saver();
+	sand::sweep_blobs();
+	sand::close_journal();
+	if (sand::store == sand::store_mode::mapped) {
+		sand::close_world_file();
 	}
 }
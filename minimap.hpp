@@ -0,0 +1,91 @@
+#ifndef SAND_HEADER_MINIMAP
+#	define SAND_HEADER_MINIMAP
+#
+#	include "chunk.hpp"
+#	include "color.hpp"
+#	include "mip.hpp"
+#	include "tile.hpp"
+#	include "world.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <unordered_map>
+
+namespace sand {
+	inline constexpr xte::u64 minimap_size = 0x20;
+
+	struct minimap_slot {
+		sand::chunk_pos pos = { 0, 0 };
+		sand::color3 color;
+		bool filled = false;
+		bool known = false;
+	};
+
+	// Slots wrap around by chunk position, so scrolling only refills the rows and columns that came into range
+	inline xte::fixed_array<sand::minimap_slot, sand::minimap_size * sand::minimap_size> minimap;
+
+	// Every chunk seen this session keeps its color after eviction
+	inline std::unordered_map<sand::chunk_pos, sand::color3, sand::chunk_pos_hash> chunk_colors;
+
+	[[nodiscard]] constexpr sand::color3 chunk_color(const sand::tile_histogram& histogram) noexcept {
+		xte::u64 r = 0;
+		xte::u64 g = 0;
+		xte::u64 b = 0;
+		for (xte::uz tile = 0; tile < sand::tiles.size(); ++tile) {
+			const xte::u64 count = histogram.count(static_cast<sand::tile_id>(tile));
+			r += count * sand::tile_colors[tile].r;
+			g += count * sand::tile_colors[tile].g;
+			b += count * sand::tile_colors[tile].b;
+		}
+		constexpr xte::u64 area = sand::chunk_w * sand::chunk_h;
+		return sand::color3(static_cast<xte::u8>(r / area), static_cast<xte::u8>(g / area), static_cast<xte::u8>(b / area));
+	}
+
+	[[nodiscard]] inline sand::minimap_slot& minimap_at(const sand::chunk_pos& pos) noexcept {
+		return sand::minimap[(pos.y % sand::minimap_size) * sand::minimap_size + pos.x % sand::minimap_size];
+	}
+
+	inline void recolor_chunk(const sand::chunk_pos& pos) {
+		const auto* chunk = sand::find_chunk(pos);
+		if (!chunk) {
+			return;
+		}
+		const sand::color3 color = sand::chunk_color(chunk->histogram);
+		sand::chunk_colors[pos] = color;
+		if (auto& slot = sand::minimap_at(pos); slot.filled && (slot.pos == pos)) {
+			slot.color = color;
+			slot.known = true;
+		}
+	}
+
+	// Only chunks that changed or were loaded this tick are recolored, each from its histogram
+	inline void update_minimap() {
+		for (xte::uz i = 0; i < sand::tile_changes.size(); ++i) {
+			const sand::chunk_pos pos = sand::chunk_of(sand::tile_changes[i].pos);
+			if (!i || (pos != sand::chunk_of(sand::tile_changes[i - 1].pos))) {
+				sand::recolor_chunk(pos);
+			}
+		}
+		for (auto&& pos : sand::inserted_chunks) {
+			sand::recolor_chunk(pos);
+		}
+	}
+
+	// Refills the slots whose chunk scrolled out of range, with `center` the middle of the map
+	inline void scroll_minimap(const sand::chunk_pos& center) {
+		for (xte::u64 y = 0; y < sand::minimap_size; ++y) {
+			for (xte::u64 x = 0; x < sand::minimap_size; ++x) {
+				const sand::chunk_pos pos = { center.x + x - sand::minimap_size / 2, center.y + y - sand::minimap_size / 2 };
+				auto& slot = sand::minimap_at(pos);
+				if (slot.filled && (slot.pos == pos)) {
+					continue;
+				}
+				const auto iter = sand::chunk_colors.find(pos);
+				slot = { pos, (iter != sand::chunk_colors.end()) ? iter->second : sand::color3(), true, iter != sand::chunk_colors.end() };
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SAND_HEADER_MIP
+#	define SAND_HEADER_MIP
+#
+#	include "chunk.hpp"
+#	include "color.hpp"
+#	include "get_color.hpp"
+#	include "pos.hpp"
+#	include "texture.hpp"
+#	include "texture_data.hpp"
+#	include "tile.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+
+namespace sand {
+	// The first frame of each tile averaged as it is drawn, with transparent tiles over void
+	inline constexpr auto tile_colors = ([] {
+		xte::fixed_array<sand::color3, sand::tiles.size()> colors;
+		for (xte::uz tile = 0; tile < sand::tiles.size(); ++tile) {
+			xte::u64 r = 0;
+			xte::u64 g = 0;
+			xte::u64 b = 0;
+			for (xte::uz i = 0; i < (sand::texture_w * sand::texture_h); ++i) {
+				sand::color4 color = sand::get_color(sand::texture_data[sand::textures[sand::tiles[tile].texture_index].frames[0]][i]);
+				if (!color.a && sand::tiles[tile].transparent) {
+					color = sand::get_color(sand::texture_data[sand::textures[0x00].frames[0]][i]);
+				}
+				if (color.a) {
+					r += color.r;
+					g += color.g;
+					b += color.b;
+				}
+			}
+			constexpr xte::u64 pixels = sand::texture_w * sand::texture_h;
+			colors[tile] = sand::color3(static_cast<xte::u8>(r / pixels), static_cast<xte::u8>(g / pixels), static_cast<xte::u8>(b / pixels));
+		}
+		return colors;
+	})();
+
+	struct mip_sum {
+		xte::u16 r = 0;
+		xte::u16 g = 0;
+		xte::u16 b = 0;
+
+		constexpr void add(const sand::color3& color) noexcept {
+			this->r = static_cast<xte::u16>(this->r + color.r);
+			this->g = static_cast<xte::u16>(this->g + color.g);
+			this->b = static_cast<xte::u16>(this->b + color.b);
+		}
+
+		constexpr void remove(const sand::color3& color) noexcept {
+			this->r = static_cast<xte::u16>(this->r - color.r);
+			this->g = static_cast<xte::u16>(this->g - color.g);
+			this->b = static_cast<xte::u16>(this->b - color.b);
+		}
+
+		[[nodiscard]] constexpr sand::color3 average(xte::u64 count) const noexcept {
+			return sand::color3(static_cast<xte::u8>(this->r / count), static_cast<xte::u8>(this->g / count), static_cast<xte::u8>(this->b / count));
+		}
+	};
+
+	// Summed tile colors over 2x2 and 4x4 blocks, so a changed tile adjusts one sum at each level
+	struct chunk_mip {
+		xte::fixed_array<sand::mip_sum, (sand::chunk_w / 2) * (sand::chunk_h / 2)> half;
+		xte::fixed_array<sand::mip_sum, (sand::chunk_w / 4) * (sand::chunk_h / 4)> quarter;
+
+		constexpr void add(xte::u64 x, xte::u64 y, sand::tile_id tile) noexcept {
+			this->half[y / 2 * (sand::chunk_w / 2) + x / 2].add(sand::tile_colors[tile]);
+			this->quarter[y / 4 * (sand::chunk_w / 4) + x / 4].add(sand::tile_colors[tile]);
+		}
+
+		constexpr void remove(xte::u64 x, xte::u64 y, sand::tile_id tile) noexcept {
+			this->half[y / 2 * (sand::chunk_w / 2) + x / 2].remove(sand::tile_colors[tile]);
+			this->quarter[y / 4 * (sand::chunk_w / 4) + x / 4].remove(sand::tile_colors[tile]);
+		}
+
+		// Cells are counted in blocks of `scale` tiles, which is 2 or 4
+		[[nodiscard]] constexpr sand::color3 at(xte::u64 scale, xte::u64 x, xte::u64 y) const noexcept {
+			return (scale == 2)
+				? this->half[y * (sand::chunk_w / 2) + x].average(4)
+				: this->quarter[y * (sand::chunk_w / 4) + x].average(16);
+		}
+	};
+
+	[[nodiscard]] constexpr sand::chunk_mip build_mip(const sand::chunk& chunk) noexcept {
+		sand::chunk_mip mip;
+		for (xte::u64 tile_y = 0; tile_y < sand::chunk_h; ++tile_y) {
+			for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+				mip.add(tile_x, tile_y, chunk.at(tile_x, tile_y));
+			}
+		}
+		return mip;
+	}
+}
+
+#endif
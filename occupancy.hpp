@@ -0,0 +1,89 @@
+#ifndef SAND_HEADER_OCCUPANCY
+#	define SAND_HEADER_OCCUPANCY
+#
+#	include "chunk.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <functional>
+#	include <unordered_map>
+#	include <vector>
+
+namespace sand {
+	// How many resident chunks under a node are present, all void, uniform and dirty
+	struct occupancy_node {
+		xte::u64 present = 0;
+		xte::u64 empty = 0;
+		xte::u64 uniform = 0;
+		xte::u64 dirty = 0;
+
+		[[nodiscard]] constexpr bool occupied() const noexcept {
+			return this->present > this->empty;
+		}
+
+		[[nodiscard]] friend constexpr bool operator==(const sand::occupancy_node&, const sand::occupancy_node&) noexcept = default;
+	};
+
+	// Level 0 holds single chunks and each level above merges 2x2 nodes, so the top level covers 0x10000 chunks a side
+	// Nodes with nothing present are erased, so the pyramid only spans resident chunks
+	inline constexpr xte::uz occupancy_levels = 0x11;
+	inline xte::fixed_array<std::unordered_map<sand::chunk_pos, sand::occupancy_node, sand::chunk_pos_hash>, sand::occupancy_levels> occupancy;
+
+	inline void set_occupancy(const sand::chunk_pos& pos, const sand::occupancy_node& node) {
+		const auto iter = sand::occupancy[0].find(pos);
+		const sand::occupancy_node old = (iter != sand::occupancy[0].end()) ? iter->second : sand::occupancy_node();
+		if (old == node) {
+			return;
+		}
+		for (xte::uz level = 0; level < sand::occupancy_levels; ++level) {
+			const sand::chunk_pos key = { pos.x >> level, pos.y >> level };
+			auto& entry = sand::occupancy[level][key];
+			entry.present += node.present - old.present;
+			entry.empty += node.empty - old.empty;
+			entry.uniform += node.uniform - old.uniform;
+			entry.dirty += node.dirty - old.dirty;
+			if (!entry.present) {
+				sand::occupancy[level].erase(key);
+			}
+		}
+	}
+
+	// Coordinates wrap, so a range is tested by its distance from `min`
+	[[nodiscard]] constexpr bool occupancy_overlaps(xte::u64 key, xte::uz level, xte::u64 min, xte::u64 max) noexcept {
+		const xte::u64 start = key << level;
+		return ((min - start) < (xte::u64(1) << level)) || ((start - min) <= (max - min));
+	}
+
+	inline void collect_occupancy(xte::uz level, const sand::chunk_pos& key, const sand::chunk_pos& min, const sand::chunk_pos& max, const std::function<bool(const sand::occupancy_node&)>& want, std::vector<sand::chunk_pos>& found) {
+		if (!level) {
+			found.push_back(key);
+			return;
+		}
+		for (xte::u64 i = 0; i < 4; ++i) {
+			const sand::chunk_pos child = { key.x * 2 + i % 2, key.y * 2 + i / 2 };
+			const auto iter = sand::occupancy[level - 1].find(child);
+			if ((iter != sand::occupancy[level - 1].end()) && want(iter->second) && sand::occupancy_overlaps(child.x, level - 1, min.x, max.x) && sand::occupancy_overlaps(child.y, level - 1, min.y, max.y)) {
+				sand::collect_occupancy(level - 1, child, min, max, want, found);
+			}
+		}
+	}
+
+	// Finds resident chunks in the rectangle between two corners, inclusive, descending only into nodes that pass `want`
+	[[nodiscard]] inline std::vector<sand::chunk_pos> find_chunks(const sand::chunk_pos& min, const sand::chunk_pos& max, const std::function<bool(const sand::occupancy_node&)>& want) {
+		std::vector<sand::chunk_pos> found;
+		constexpr xte::uz top = sand::occupancy_levels - 1;
+		for (auto&& [key, node] : sand::occupancy[top]) {
+			if (want(node) && sand::occupancy_overlaps(key.x, top, min.x, max.x) && sand::occupancy_overlaps(key.y, top, min.y, max.y)) {
+				sand::collect_occupancy(top, key, min, max, want, found);
+			}
+		}
+		return found;
+	}
+
+	[[nodiscard]] inline std::vector<sand::chunk_pos> find_chunks(const std::function<bool(const sand::occupancy_node&)>& want) {
+		return sand::find_chunks({ 0, 0 }, { ~xte::u64(0), ~xte::u64(0) }, want);
+	}
+}
+
+#endif
@@ -0,0 +1,274 @@
+#ifndef SAND_HEADER_SAVE
+#	define SAND_HEADER_SAVE
+#
+#	include "chunk.hpp"
+#	include "log.hpp"
+#	include "tile.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/data/is_whitespace.hpp>
+#	include <xte/data/string.hpp>
+#	include <xte/data/string_view.hpp>
+#	include <xte/io/file.hpp>
+#	include <xte/io/file_mode.hpp>
+#	include <xte/math/parse_number.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <fcntl.h>
+#	include <unistd.h>
+#
+#	include <filesystem>
+#	include <format>
+#	include <iterator>
+#	include <mutex>
+#	include <string>
+#	include <system_error>
+#	include <thread>
+
+namespace sand {
+	inline constexpr xte::string_view save_dir = "save";
+
+	enum class store_mode {
+		files,
+		mapped
+	};
+
+	inline sand::store_mode store = sand::store_mode::files;
+
+	[[nodiscard]] inline xte::u64 parse_hex(xte::string_view data, xte::uz& i) {
+		while ((i < data.size()) && xte::is_whitespace(data[i])) {
+			++i;
+		}
+		auto [number, length] = xte::parse_number<xte::u64>.with_index(data.subview(i), 16);
+		if (!length) {
+			sand::log("failed to parse save data");
+			throw;
+		}
+		i += length;
+		return number;
+	}
+
+	[[nodiscard]] inline std::string chunk_path(const sand::chunk_pos& pos) {
+		return std::format("{}/chunks/{:0>16X} {:0>16X}.txt", sand::save_dir, pos.x, pos.y);
+	}
+
+	[[nodiscard]] inline std::string blob_dir() {
+		return std::format("{}/blobs", sand::save_dir);
+	}
+
+	[[nodiscard]] inline std::string blob_path(xte::u64 hash) {
+		return std::format("{}/{:0>16X}.txt", sand::blob_dir(), hash);
+	}
+
+	// An `@` line with the tick the chunk was saved at comes first, so journal replay knows which edits it already holds
+	// A `#` line counting each tile follows, so statistics are known without a recount
+	// It starts with how many counts follow, and tiles added since the file was written count as zero
+	// Files written before either existed have tick zero and are counted as they are read
+	// A file with no tiles marks a chunk that was emptied, so it is not generated again
+	[[nodiscard]] inline bool read_chunk_file(const std::string& path, sand::chunk& chunk, sand::tile_histogram& histogram, sand::chunk_state& state, xte::u64& tick) {
+		if (!std::filesystem::exists(path)) {
+			return false;
+		}
+		const xte::string data = xte::file(path, xte::file_mode::read).read();
+		xte::uz i = 0;
+		tick = 0;
+		if (data.size() && (data[0] == '@')) {
+			++i;
+			tick = sand::parse_hex(data, i);
+			while ((i < data.size()) && xte::is_whitespace(data[i])) {
+				++i;
+			}
+		}
+		if (i >= data.size()) {
+			chunk.data.fill(0x00);
+			histogram = {};
+			state.clear();
+			return true;
+		}
+		const bool counted = data[i] == '#';
+		if (counted) {
+			++i;
+			histogram = {};
+			xte::u64 total = 0;
+			const xte::u64 counts = sand::parse_hex(data, i);
+			if (counts > (sand::chunk_w * sand::chunk_h)) {
+				sand::log(std::format("invalid tile counts in {}", path));
+				throw;
+			}
+			for (xte::u64 tile = 0; tile < counts; ++tile) {
+				const xte::u64 count = sand::parse_hex(data, i);
+				total += count;
+				if (count && (tile >= sand::tiles.size())) {
+					sand::log(std::format("invalid tile {:X} in {}", tile, path));
+					throw;
+				}
+				if (tile && count && (count <= (sand::chunk_w * sand::chunk_h))) {
+					histogram.counts[tile] = static_cast<xte::u16>(count);
+					histogram.filled = static_cast<xte::u16>(histogram.filled + count);
+				}
+			}
+			if (total != (sand::chunk_w * sand::chunk_h)) {
+				sand::log(std::format("invalid tile counts in {}", path));
+				throw;
+			}
+		}
+		for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
+			sand::tile_id* row = chunk.row(tile_y);
+			for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+				const xte::u64 index = sand::parse_hex(data, i);
+				if (index >= sand::tiles.size()) {
+					sand::log(std::format("invalid tile {:X} in {}", index, path));
+					throw;
+				}
+				row[tile_x] = static_cast<sand::tile_id>(index);
+			}
+		}
+		// The header is only trusted as a cache, so a grid it does not describe is rejected like any other bad file
+		if (const sand::tile_histogram recount = sand::count_tiles(chunk); !counted) {
+			histogram = recount;
+		} else if (histogram != recount) {
+			sand::log(std::format("tile counts do not match tiles in {}", path));
+			throw;
+		}
+		state.clear();
+		while (true) {
+			while ((i < data.size()) && xte::is_whitespace(data[i])) {
+				++i;
+			}
+			if (i >= data.size()) {
+				break;
+			}
+			const xte::u64 index = sand::parse_hex(data, i);
+			const xte::u64 value = sand::parse_hex(data, i);
+			if ((index >= (sand::chunk_w * sand::chunk_h)) || (value > 0xFFFFFFFF) || (!state.empty() && (index <= state.back().index))) {
+				sand::log(std::format("invalid tile state {:X} in {}", index, path));
+				throw;
+			}
+			state.push_back({ static_cast<xte::u16>(index), static_cast<xte::u32>(value) });
+		}
+		return true;
+	}
+
+	[[nodiscard]] inline bool read_chunk(const sand::chunk_pos& pos, sand::chunk& chunk, sand::tile_histogram& histogram, sand::chunk_state& state, xte::u64& tick) {
+		return sand::read_chunk_file(sand::chunk_path(pos), chunk, histogram, state, tick);
+	}
+
+	[[nodiscard]] inline std::string index_path() {
+		return std::format("{}/index.txt", sand::save_dir);
+	}
+
+	// The store mode is recorded so a run with a different `SAND_STORE` cannot silently read another copy of the world
+	[[nodiscard]] inline std::string format_index(xte::u64 tick, const sand::pos& camera_pos) {
+		return std::format("{:X} {:X} {:X} {:X} {:X} {:X}\n", tick, camera_pos.chunk_x, camera_pos.chunk_y, camera_pos.tile_x, camera_pos.tile_y, static_cast<xte::u64>(sand::store));
+	}
+
+	[[nodiscard]] inline std::string format_chunk(const sand::chunk& chunk, const sand::tile_histogram& histogram, const sand::chunk_state& state, xte::u64 tick) {
+		std::string data;
+		data.reserve(sand::chunk_w * sand::chunk_h * 3 + sand::tiles.size() * 4 + 0x20);
+		std::format_to(std::back_inserter(data), "@ {:X}\n# {:X}", tick, sand::tiles.size());
+		for (xte::uz tile = 0; tile < sand::tiles.size(); ++tile) {
+			std::format_to(std::back_inserter(data), " {:X}", histogram.count(static_cast<sand::tile_id>(tile)));
+		}
+		data += '\n';
+		for (xte::u64 tile_y = sand::chunk_h; tile_y--;) {
+			const sand::tile_id* row = chunk.row(tile_y);
+			for (xte::u64 tile_x = 0; tile_x < (sand::chunk_w - 1); ++tile_x) {
+				std::format_to(std::back_inserter(data), "{:0>2X} ", row[tile_x]);
+			}
+			std::format_to(std::back_inserter(data), "{:0>2X}\n", row[sand::chunk_w - 1]);
+		}
+		for (auto&& entry : state) {
+			std::format_to(std::back_inserter(data), "{:0>3X} {:0>8X}\n", entry.index, entry.value);
+		}
+		return data;
+	}
+
+	// The data is on disk before the rename, so a power loss leaves either the old file or the new one
+	inline void commit_file(const std::string& path, xte::string_view data) {
+		const std::string temp_path = std::format("{}.{:X}.tmp", path, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			sand::log(std::format("failed to write {}", path));
+			throw;
+		}
+		for (xte::uz i = 0; i < data.size();) {
+			const ::ssize_t written = ::write(fd, data.data() + i, data.size() - i);
+			if (written < 0) {
+				sand::log(std::format("failed to write {}", path));
+				throw;
+			}
+			i += static_cast<xte::uz>(written);
+		}
+		::fsync(fd);
+		::close(fd);
+		std::filesystem::rename(temp_path, path);
+	}
+
+	// Makes renames, links and removals inside `path` durable
+	inline void sync_dir(const std::string& path) {
+		const int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0) {
+			return;
+		}
+		::fsync(fd);
+		::close(fd);
+	}
+
+	// Blobs with the same hash are created and linked under one lock, so two writers never replace each other's blob in between
+	inline xte::fixed_array<std::mutex, 0x40> blob_mutexes;
+
+	// Identical chunk files are hard links to one immutable blob, which is never rewritten in place
+	// A blob is always compared with the chunk before reuse, since a hash match alone does not make the contents equal
+	// The save tick is part of the file, so only chunks saved at the same tick share a blob
+	[[nodiscard]] inline bool share_blob(const sand::chunk& chunk, const sand::tile_histogram& histogram, xte::u64 tick, const std::string& path) {
+		const xte::u64 hash = sand::chunk_hash(chunk) ^ (tick * 0x9E3779B97F4A7C15);
+		const std::string blob = sand::blob_path(hash);
+		auto lock = std::lock_guard(sand::blob_mutexes[hash % sand::blob_mutexes.size()]);
+		sand::chunk existing;
+		sand::tile_histogram existing_histogram;
+		sand::chunk_state existing_state;
+		xte::u64 existing_tick;
+		if (sand::read_chunk_file(blob, existing, existing_histogram, existing_state, existing_tick)) {
+			if ((existing != chunk) || (existing_histogram != histogram) || !existing_state.empty() || (existing_tick != tick)) {
+				return false;
+			}
+		} else {
+			std::filesystem::create_directories(sand::blob_dir());
+			sand::commit_file(blob, sand::format_chunk(chunk, histogram, {}, tick));
+		}
+		const std::string temp_path = std::format("{}.{:X}.tmp", path, std::hash<std::thread::id>()(std::this_thread::get_id()));
+		std::error_code error;
+		std::filesystem::remove(temp_path, error);
+		std::filesystem::create_hard_link(blob, temp_path, error);
+		if (error) {
+			return false;
+		}
+		std::filesystem::rename(temp_path, path);
+		return true;
+	}
+
+	// Only stateless chunks are shared as blobs
+	inline void write_chunk(const sand::chunk_pos& pos, const sand::chunk& chunk, const sand::tile_histogram& histogram, const sand::chunk_state& state, xte::u64 tick) {
+		std::filesystem::create_directories(std::format("{}/chunks", sand::save_dir));
+		if (histogram.empty() && state.empty()) {
+			sand::commit_file(sand::chunk_path(pos), std::format("@ {:X}\n", tick));
+			return;
+		}
+		if (!state.empty() || !sand::share_blob(chunk, histogram, tick, sand::chunk_path(pos))) {
+			sand::commit_file(sand::chunk_path(pos), sand::format_chunk(chunk, histogram, state, tick));
+		}
+	}
+
+	inline void sweep_blobs() {
+		if (!std::filesystem::exists(sand::blob_dir())) {
+			return;
+		}
+		for (const auto& blob : std::filesystem::directory_iterator(sand::blob_dir())) {
+			if ((blob.path().extension() != ".txt") || (blob.hard_link_count() < 2)) {
+				std::filesystem::remove(blob.path());
+			}
+		}
+	}
+}
+
+#endif
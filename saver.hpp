@@ -0,0 +1,122 @@
+#ifndef SAND_HEADER_SAVER
+#	define SAND_HEADER_SAVER
+#
+#	include "chunk.hpp"
+#	include "save.hpp"
+#	include "thread_pool.hpp"
+#	include "world_file.hpp"
+#
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <condition_variable>
+#	include <deque>
+#	include <memory>
+#	include <mutex>
+#	include <string>
+#	include <thread>
+#	include <utility>
+#	include <vector>
+
+namespace sand {
+	// State is null for chunks without stateful tiles
+	// The tick is the last one whose edits the tiles hold
+	struct saved_chunk {
+		sand::chunk_pos pos;
+		std::shared_ptr<sand::chunk> data;
+		std::shared_ptr<sand::chunk_state> state;
+		sand::tile_histogram histogram;
+		xte::u64 tick = 0;
+	};
+
+	struct save_batch {
+		std::vector<sand::saved_chunk> chunks;
+		std::string index;
+		std::vector<std::string> retired;
+		bool sync_mapped = false;
+	};
+
+	inline constexpr xte::u64 autosave_interval = 0x100;
+
+	inline std::mutex save_mutex;
+	inline std::condition_variable save_signal;
+	inline std::deque<sand::save_batch> save_queue;
+	inline bool save_stopping = false;
+	inline std::thread save_thread;
+
+	// Sized like `sand::workers` but kept apart from it, so threads blocked on disk never hold up the simulation or drawing of a frame
+	inline sand::thread_pool save_workers(std::max(std::thread::hardware_concurrency(), 1u));
+
+	inline void run_saver() {
+		auto lock = std::unique_lock(sand::save_mutex);
+		while (true) {
+			sand::save_signal.wait(lock, [] -> bool {
+				return sand::save_stopping || !sand::save_queue.empty();
+			});
+			if (sand::save_queue.empty()) {
+				return;
+			}
+			const sand::save_batch& batch = sand::save_queue.front();
+			lock.unlock();
+			sand::save_workers.parallel_for(batch.chunks.size(), [&](xte::uz i) -> void {
+				const auto& saved = batch.chunks[i];
+				sand::write_chunk(saved.pos, *saved.data, saved.histogram, saved.state ? *saved.state : sand::chunk_state(), saved.tick);
+			});
+			if (batch.sync_mapped) {
+				sand::sync_world_file(true);
+			}
+			// Chunk files must be durable before the index that covers them, and the index before the journal it replaces is removed
+			sand::sync_dir(std::format("{}/chunks", sand::save_dir));
+			sand::sync_dir(sand::blob_dir());
+			if (!batch.index.empty()) {
+				std::filesystem::create_directories(std::format("{}", sand::save_dir));
+				sand::commit_file(sand::index_path(), batch.index);
+			}
+			sand::sync_dir(std::string(sand::save_dir));
+			for (auto&& path : batch.retired) {
+				std::filesystem::remove(path);
+			}
+			lock.lock();
+			sand::save_queue.pop_front();
+		}
+	}
+
+	inline void start_saver() {
+		sand::save_thread = std::thread(sand::run_saver);
+	}
+
+	inline void stop_saver() {
+		{
+			auto lock = std::lock_guard(sand::save_mutex);
+			sand::save_stopping = true;
+		}
+		sand::save_signal.notify_one();
+		sand::save_thread.join();
+	}
+
+	inline void queue_save(sand::save_batch&& batch) {
+		if (batch.chunks.empty() && batch.index.empty() && batch.retired.empty()) {
+			return;
+		}
+		{
+			auto lock = std::lock_guard(sand::save_mutex);
+			sand::save_queue.push_back(std::move(batch));
+		}
+		sand::save_signal.notify_one();
+	}
+
+	// Chunks queued for writing are newer than their files on disk
+	[[nodiscard]] inline sand::saved_chunk find_pending(const sand::chunk_pos& pos) {
+		auto lock = std::lock_guard(sand::save_mutex);
+		for (auto batch = sand::save_queue.rbegin(); batch != sand::save_queue.rend(); ++batch) {
+			for (auto&& pending : batch->chunks) {
+				if (pending.pos == pos) {
+					return pending;
+				}
+			}
+		}
+		return { pos, nullptr, nullptr, {}, 0 };
+	}
+}
+
+#endif
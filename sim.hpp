@@ -0,0 +1,330 @@
+#ifndef SAND_HEADER_SIM
+#	define SAND_HEADER_SIM
+#
+#	include "chunk.hpp"
+#	include "pos.hpp"
+#	include "thread_pool.hpp"
+#	include "tile.hpp"
+#	include "world.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <cstdint>
+#	include <vector>
+
+namespace sand {
+	// Depends only on the tick and position, so a replayed step makes the same choices
+	[[nodiscard]] inline xte::u64 sim_random(const sand::pos& pos) noexcept {
+		xte::u64 hash = sand::tick * 0xD6E8FEB86659FD93;
+		hash ^= (pos.chunk_x * sand::chunk_w + pos.tile_x) * 0x9E3779B97F4A7C15;
+		hash ^= (pos.chunk_y * sand::chunk_h + pos.tile_y) * 0xC2B2AE3D27D4EB4F;
+		return hash ^ (hash >> 31);
+	}
+
+	struct sim_move {
+		sand::pos from;
+		sand::pos to;
+		sand::tile_id tile;
+	};
+
+	// One chunk stepped in a phase, with its 3x3 neighborhood resolved up front so workers never search the world
+	struct sim_job {
+		sand::chunk_pos pos;
+		xte::fixed_array<sand::world_chunk*, 9> around = {};
+		std::vector<sand::tile_change> changes;
+		std::vector<sand::sim_move> deferred;
+
+		[[nodiscard]] sand::world_chunk* chunk() const noexcept {
+			return this->around[4];
+		}
+
+		[[nodiscard]] sand::world_chunk* chunk_of(const sand::pos& pos) const noexcept {
+			return this->around[(pos.chunk_y - this->pos.y + 1) * 3 + (pos.chunk_x - this->pos.x + 1)];
+		}
+
+		[[nodiscard]] sand::tile_motion motion_at(const sand::pos& pos) const {
+			const auto* chunk = this->chunk_of(pos);
+			return chunk ? sand::tiles[chunk->tiles().at(pos.tile_x, pos.tile_y)].motion : sand::tile_motion::fixed;
+		}
+	};
+
+	// Moves into void, and granular tiles also sink through fluids by swapping with them
+	[[nodiscard]] constexpr bool sim_passable(sand::tile_id tile, sand::tile_id other) noexcept {
+		return !other || ((sand::tiles[tile].motion == sand::tile_motion::granular) && (sand::tiles[other].motion == sand::tile_motion::fluid));
+	}
+
+	inline void swap_tiles(sand::world_chunk& chunk, sand::world_chunk& target, const sand::sim_move& move, sand::tile_id other, std::vector<sand::tile_change>& changes) {
+		sand::set_tile(target, move.to, move.tile, changes);
+		sand::set_tile(chunk, move.from, other, changes);
+		target.stepping.reset(sand::tile_index(move.to));
+	}
+
+	// Moves within the job's chunk happen at once; moves into a neighbor are only recorded, since another job may read it
+	[[nodiscard]] inline bool try_move(sand::sim_job& job, const sand::pos& from, const sand::pos& to) {
+		auto* target = job.chunk_of(to);
+		if (!target) {
+			return false;
+		}
+		const sand::tile_id tile = job.chunk()->tiles().at(from.tile_x, from.tile_y);
+		const sand::tile_id other = target->tiles().at(to.tile_x, to.tile_y);
+		if (!sand::sim_passable(tile, other)) {
+			return false;
+		}
+		if (target == job.chunk()) {
+			sand::swap_tiles(*job.chunk(), *target, { from, to, tile }, other, job.changes);
+		} else {
+			job.deferred.push_back({ from, to, tile });
+		}
+		return true;
+	}
+
+	inline void step_tile(sand::sim_job& job, const sand::pos& pos) {
+		const sand::tile_motion motion = sand::tiles[job.chunk()->tiles().at(pos.tile_x, pos.tile_y)].motion;
+		if (motion == sand::tile_motion::fixed) {
+			return;
+		}
+		const bool left_first = sand::sim_random(pos) & 1;
+		const sand::pos below = pos - sand::pos(0, 0, 0, 1);
+		const sand::pos first_side = left_first ? (pos - sand::pos(0, 0, 1, 0)) : (pos + sand::pos(0, 0, 1, 0));
+		const sand::pos second_side = left_first ? (pos + sand::pos(0, 0, 1, 0)) : (pos - sand::pos(0, 0, 1, 0));
+		if (sand::try_move(job, pos, below) || sand::try_move(job, pos, first_side - sand::pos(0, 0, 0, 1)) || sand::try_move(job, pos, second_side - sand::pos(0, 0, 0, 1))) {
+			return;
+		}
+		// Fluids only spread sideways under another fluid, so a puddle one tile deep settles
+		if ((motion == sand::tile_motion::fluid) && (job.motion_at(pos + sand::pos(0, 0, 0, 1)) == sand::tile_motion::fluid)) {
+			static_cast<void>(sand::try_move(job, pos, first_side) || sand::try_move(job, pos, second_side));
+		}
+	}
+
+	// Deferred moves are checked again, since an earlier one may have filled the target or emptied the source
+	inline void apply_deferred(sand::sim_job& job) {
+		for (auto&& move : job.deferred) {
+			auto& chunk = *job.chunk();
+			auto& target = *job.chunk_of(move.to);
+			const sand::tile_id other = target.tiles().at(move.to.tile_x, move.to.tile_y);
+			if ((chunk.tiles().at(move.from.tile_x, move.from.tile_y) == move.tile) && sand::sim_passable(move.tile, other)) {
+				sand::swap_tiles(chunk, target, move, other, job.changes);
+			} else {
+				sand::wake_tile(move.from);
+			}
+		}
+	}
+
+	inline void wake_changes(xte::uz first) {
+		for (xte::uz i = first; i < sand::tile_changes.size(); ++i) {
+			sand::wake_around(sand::tile_changes[i].pos);
+		}
+	}
+
+	[[nodiscard]] inline const sand::tile& tile_at(const sand::pos& pos) {
+		const auto* chunk = sand::find_chunk(sand::chunk_of(pos));
+		return sand::tiles[chunk ? chunk->tiles().at(pos.tile_x, pos.tile_y) : 0x00];
+	}
+
+	struct conveyor {
+		sand::pos pos;
+		sand::conveyor_dir dir;
+		sand::pos source;
+		sand::pos target;
+		xte::uz downstream = SIZE_MAX;
+		bool takes = false;
+		bool hands = false;
+		bool visited = false;
+	};
+
+	[[nodiscard]] constexpr bool conveyor_before(const sand::pos& lhs, const sand::pos& rhs) noexcept {
+		if (lhs.chunk_y != rhs.chunk_y) {
+			return lhs.chunk_y < rhs.chunk_y;
+		}
+		if (lhs.chunk_x != rhs.chunk_x) {
+			return lhs.chunk_x < rhs.chunk_x;
+		}
+		return sand::tile_index(lhs) < sand::tile_index(rhs);
+	}
+
+	// Horizontal belts carry the tile resting on them sideways
+	// Vertical belts hold a tile in their state and pass it one belt per tick, taking it in below an up column or above a down column
+	inline void conveyor_route(sand::conveyor& belt) {
+		const sand::pos up = sand::pos(0, 0, 0, 1);
+		switch (belt.dir) {
+		case sand::conveyor_dir::right:
+			belt.source = belt.pos + up;
+			belt.target = belt.source + sand::pos(0, 0, 1, 0);
+			break;
+		case sand::conveyor_dir::left:
+			belt.source = belt.pos + up;
+			belt.target = belt.source - sand::pos(0, 0, 1, 0);
+			break;
+		case sand::conveyor_dir::up:
+			belt.source = belt.pos - up;
+			belt.target = belt.pos + up;
+			break;
+		case sand::conveyor_dir::down:
+			belt.source = belt.pos + up;
+			belt.target = belt.pos - up;
+			break;
+		default:
+			return;
+		}
+		belt.takes = !sand::conveyor_vertical(belt.dir) || (sand::tile_at(belt.source).conveyor != belt.dir);
+		belt.hands = sand::conveyor_vertical(belt.dir) && (sand::tile_at(belt.target).conveyor == belt.dir);
+	}
+
+	inline void conveyor_move(const sand::conveyor& belt) {
+		auto* from = sand::find_chunk(sand::chunk_of(belt.source));
+		auto* to = sand::find_chunk(sand::chunk_of(belt.target));
+		if (!from || !to) {
+			return;
+		}
+		const sand::tile_id tile = from->tiles().at(belt.source.tile_x, belt.source.tile_y);
+		const sand::tile_id other = to->tiles().at(belt.target.tile_x, belt.target.tile_y);
+		if ((sand::tiles[tile].motion != sand::tile_motion::fixed) && sand::sim_passable(tile, other)) {
+			sand::set_tile(*to, belt.target, tile);
+			sand::set_tile(*from, belt.source, other);
+		}
+	}
+
+	// A vertical belt first passes on what it holds, then takes in a new tile if it starts its column
+	// Belts still holding a tile stay awake, since nothing around them changes while it waits
+	// A belt that just emptied is woken once more, so its chunk is seen by `sand::update_occupancy`
+	inline void conveyor_carry(const sand::conveyor& belt) {
+		auto& chunk = *sand::find_chunk(sand::chunk_of(belt.pos));
+		const xte::uz index = sand::tile_index(belt.pos);
+		const xte::u32 initial = chunk.state_at(index);
+		xte::u32 held = initial;
+		if (held >= sand::tiles.size()) {
+			chunk.set_state(index, held = 0);
+		}
+		if (auto* to = sand::find_chunk(sand::chunk_of(belt.target)); held && to) {
+			if (belt.hands && !to->state_at(sand::tile_index(belt.target))) {
+				to->set_state(sand::tile_index(belt.target), held);
+				chunk.set_state(index, held = 0);
+				sand::wake_tile(belt.target);
+				sand::carry_changes.push_back(belt.target);
+			} else if (!belt.hands && !to->tiles().at(belt.target.tile_x, belt.target.tile_y)) {
+				sand::set_tile(*to, belt.target, static_cast<sand::tile_id>(held));
+				chunk.set_state(index, held = 0);
+			}
+		}
+		if (auto* from = sand::find_chunk(sand::chunk_of(belt.source)); !held && belt.takes && from) {
+			const sand::tile_id tile = from->tiles().at(belt.source.tile_x, belt.source.tile_y);
+			if (sand::tiles[tile].motion != sand::tile_motion::fixed) {
+				chunk.set_state(index, held = tile);
+				sand::set_tile(*from, belt.source, 0x00);
+			}
+		}
+		if (held || (held != initial)) {
+			sand::wake_tile(belt.pos);
+		}
+		if (held != initial) {
+			sand::carry_changes.push_back(belt.pos);
+		}
+	}
+
+	// Woken belts move what they carry one step per tick, downstream belts first, so a loaded chain advances together
+	inline void step_conveyors() {
+		std::vector<sand::chunk_pos> chunks(sand::conveyor_chunks.begin(), sand::conveyor_chunks.end());
+		std::ranges::sort(chunks, [](const sand::chunk_pos& lhs, const sand::chunk_pos& rhs) -> bool {
+			return (lhs.y != rhs.y) ? (lhs.y < rhs.y) : (lhs.x < rhs.x);
+		});
+		sand::conveyor_chunks.clear();
+		std::vector<sand::conveyor> belts;
+		for (auto&& pos : chunks) {
+			sand::touch_around(pos);
+			auto& chunk = sand::world.at(pos);
+			xte::uz index;
+			while (chunk.conveying.take(index)) {
+				const sand::pos belt_pos = sand::pos(pos.x, pos.y, index % sand::chunk_w, index / sand::chunk_w);
+				sand::conveyor belt = { belt_pos, sand::tiles[chunk.tiles().at(belt_pos.tile_x, belt_pos.tile_y)].conveyor, belt_pos, belt_pos };
+				sand::conveyor_route(belt);
+				if (chunk.state_at(index) || (belt.takes && (sand::tile_at(belt.source).motion != sand::tile_motion::fixed))) {
+					belts.push_back(belt);
+				}
+			}
+		}
+		// The downstream belt is the one whose source is this belt's target
+		auto find = [&](const sand::pos& pos, bool up) -> xte::uz {
+			const auto iter = std::ranges::lower_bound(belts, pos, sand::conveyor_before, &sand::conveyor::pos);
+			if ((iter == belts.end()) || (iter->pos != pos) || ((iter->dir == sand::conveyor_dir::up) != up)) {
+				return SIZE_MAX;
+			}
+			return static_cast<xte::uz>(iter - belts.begin());
+		};
+		for (auto& belt : belts) {
+			if (belt.hands) {
+				const auto iter = std::ranges::lower_bound(belts, belt.target, sand::conveyor_before, &sand::conveyor::pos);
+				belt.downstream = ((iter != belts.end()) && (iter->pos == belt.target)) ? static_cast<xte::uz>(iter - belts.begin()) : SIZE_MAX;
+				continue;
+			}
+			belt.downstream = find(belt.target - sand::pos(0, 0, 0, 1), false);
+			if (belt.downstream == SIZE_MAX) {
+				belt.downstream = find(belt.target + sand::pos(0, 0, 0, 1), true);
+			}
+		}
+		std::vector<xte::uz> path;
+		for (xte::uz i = 0; i < belts.size(); ++i) {
+			for (xte::uz j = i; (j != SIZE_MAX) && !belts[j].visited; j = belts[j].downstream) {
+				belts[j].visited = true;
+				path.push_back(j);
+			}
+			for (; !path.empty(); path.pop_back()) {
+				auto& belt = belts[path.back()];
+				if (sand::conveyor_vertical(belt.dir)) {
+					sand::conveyor_carry(belt);
+				} else {
+					sand::conveyor_move(belt);
+				}
+			}
+		}
+	}
+
+	// Four phases of a 2x2 chunk checkerboard, so chunks stepped together are two apart and only ever read their shared neighbors
+	// Each phase steps its chunks in parallel, then applies their cross-chunk moves and merges their changes in chunk order
+	// Rows are stepped bottom to top, and tiles that do not move are dropped from the active set
+	inline void step_world() {
+		sand::wake_changes(0);
+		xte::uz conveyed = sand::tile_changes.size();
+		sand::step_conveyors();
+		sand::wake_changes(conveyed);
+		std::vector<sand::chunk_pos> stepped(sand::awake_chunks.begin(), sand::awake_chunks.end());
+		std::ranges::sort(stepped, [](const sand::chunk_pos& lhs, const sand::chunk_pos& rhs) -> bool {
+			return (lhs.y != rhs.y) ? (lhs.y < rhs.y) : (lhs.x < rhs.x);
+		});
+		sand::awake_chunks.clear();
+		xte::fixed_array<std::vector<sand::sim_job>, 4> phases;
+		for (auto&& pos : stepped) {
+			auto& job = phases[(pos.y & 1) * 2 + (pos.x & 1)].emplace_back(pos);
+			for (xte::u64 i = 0; i < job.around.size(); ++i) {
+				if (const auto iter = sand::world.find({ pos.x + i % 3 - 1, pos.y + i / 3 - 1 }); iter != sand::world.end()) {
+					sand::touch_chunk(iter->second);
+					iter->second.thaw();
+					job.around[i] = &iter->second;
+				}
+			}
+			job.chunk()->stepping = job.chunk()->active;
+			job.chunk()->active.reset();
+		}
+		const xte::uz first = sand::tile_changes.size();
+		for (auto& jobs : phases) {
+			sand::workers.parallel_for(jobs.size(), [&](xte::uz i) -> void {
+				auto& job = jobs[i];
+				xte::uz index;
+				while (job.chunk()->stepping.take(index)) {
+					sand::step_tile(job, sand::pos(job.pos.x, job.pos.y, index % sand::chunk_w, index / sand::chunk_w));
+				}
+			});
+			for (auto& job : jobs) {
+				sand::apply_deferred(job);
+				for (auto&& change : job.changes) {
+					job.chunk_of(change.pos)->version = ++sand::world_version;
+				}
+				sand::tile_changes.insert(sand::tile_changes.end(), job.changes.begin(), job.changes.end());
+			}
+		}
+		sand::wake_changes(first);
+	}
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SAND_HEADER_STATS
+#	define SAND_HEADER_STATS
+#
+#	include "chunk.hpp"
+#	include "occupancy.hpp"
+#	include "pos.hpp"
+#	include "tile.hpp"
+#	include "world.hpp"
+#
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <vector>
+
+namespace sand {
+	// Counts `tile` in the rectangle between two corners, inclusive, within resident chunks only
+	// Void areas are skipped through the occupancy index, chunks wholly inside are answered from their histograms, and only the edge chunks are scanned
+	[[nodiscard]] inline xte::u64 count_region(const sand::pos& min, const sand::pos& max, sand::tile_id tile) {
+		xte::u64 total = 0;
+		const std::vector<sand::chunk_pos> chunks = sand::find_chunks(sand::chunk_of(min), sand::chunk_of(max), [&](const sand::occupancy_node& node) -> bool {
+			return !tile || node.occupied();
+		});
+		for (auto&& pos : chunks) {
+			const auto& chunk = sand::world.at(pos);
+			const xte::u64 first_x = (pos.x == min.chunk_x) ? min.tile_x : 0;
+			const xte::u64 first_y = (pos.y == min.chunk_y) ? min.tile_y : 0;
+			const xte::u64 last_x = (pos.x == max.chunk_x) ? max.tile_x : (sand::chunk_w - 1);
+			const xte::u64 last_y = (pos.y == max.chunk_y) ? max.tile_y : (sand::chunk_h - 1);
+			const xte::u64 area = (last_x - first_x + 1) * (last_y - first_y + 1);
+			const xte::u64 count = chunk.histogram.count(tile);
+			if ((count == 0) || (count == (sand::chunk_w * sand::chunk_h)) || (area == (sand::chunk_w * sand::chunk_h))) {
+				total += std::min(count, area);
+				continue;
+			}
+			const auto& tiles = chunk.tiles();
+			for (xte::u64 tile_y = first_y; tile_y <= last_y; ++tile_y) {
+				const sand::tile_id* row = tiles.row(tile_y);
+				total += static_cast<xte::u64>(std::count(row + first_x, row + last_x + 1, tile));
+			}
+		}
+		return total;
+	}
+}
+
+#endif
@@ -51,7 +51,9 @@ namespace sand {
 		/* 0x1F: conveyor right */                   { 0x27, 0x27, 0x28, 0x28, 0x29, 0x29, 0x2A, 0x2A },
 		/* 0x20: conveyor left */                    { 0x2B, 0x2B, 0x2C, 0x2C, 0x2D, 0x2D, 0x2E, 0x2E },
 		/* 0x21: conveyor up */                      { 0x2F, 0x2F, 0x30, 0x30, 0x31, 0x31, 0x32, 0x32 },
-		/* 0x22: conveyor down */                    { 0x33, 0x33, 0x34, 0x34, 0x35, 0x35, 0x36, 0x36 }
+		/* 0x22: conveyor down */                    { 0x33, 0x33, 0x34, 0x34, 0x35, 0x35, 0x36, 0x36 },
+		/* 0x23: sand */                             { 0x37 },
+		/* 0x24: water */                            { 0x38, 0x38, 0x38, 0x38, 0x39, 0x39, 0x39, 0x39 }
 	});
 }
 
@@ -504,6 +504,33 @@ namespace sand {
 		"&&####*%"
 		"&%@##@&%"
 		"%&!@@!*&"
+		,
+		"qwqqwqeq" // 0x37: sand
+		"wqqeqqwq"
+		"qqwqqwqq"
+		"eqqqwqqe"
+		"qwqeqqwq"
+		"qqwqqqqw"
+		"wqqwqeqq"
+		"qeqqwqqq"
+		,
+		"kkMMkkkk" // 0x38: water (frame 0)
+		"kkkkkkMM"
+		"kk,,kkkk"
+		"kkkkkkkk"
+		"MMkkkk,,"
+		"kkkkkkkk"
+		"kkk,,kkk"
+		"kkkkkkkk"
+		,
+		"kkkkMMkk" // 0x39: water (frame 1)
+		"MMkkkkkk"
+		"kkkk,,kk"
+		"kkkkkkkk"
+		"kkMMkkkk"
+		"kkkkkkkk"
+		",,kkkkk,"
+		"kkkkkkkk"
 	});
 }
 
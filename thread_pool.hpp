@@ -0,0 +1,156 @@
+#ifndef SAND_HEADER_THREAD_POOL
+#	define SAND_HEADER_THREAD_POOL
+#
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <atomic>
+#	include <condition_variable>
+#	include <deque>
+#	include <functional>
+#	include <memory>
+#	include <mutex>
+#	include <thread>
+#	include <vector>
+
+namespace sand {
+	struct thread_pool {
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable signal;
+		std::deque<std::function<void()>> tasks;
+		bool stopping = false;
+
+		[[nodiscard]] explicit thread_pool(xte::uz count) {
+			for (xte::uz i = 0; i < count; ++i) {
+				this->threads.emplace_back([this] -> void {
+					while (true) {
+						std::function<void()> task;
+						{
+							auto lock = std::unique_lock(this->mutex);
+							this->signal.wait(lock, [this] -> bool {
+								return this->stopping || !this->tasks.empty();
+							});
+							if (this->tasks.empty()) {
+								return;
+							}
+							task = std::move(this->tasks.front());
+							this->tasks.pop_front();
+						}
+						task();
+					}
+				});
+			}
+		}
+
+		thread_pool(const sand::thread_pool&) = delete;
+
+		~thread_pool() {
+			{
+				auto lock = std::lock_guard(this->mutex);
+				this->stopping = true;
+			}
+			this->signal.notify_all();
+			for (auto& thread : this->threads) {
+				thread.join();
+			}
+		}
+
+		// Runs `function(i)` for every `i` below `count`, with the calling thread helping until all are done
+		// Each participant starts on its own slice, then steals the back half of another slice once its own runs out
+		void parallel_for(xte::uz count, const std::function<void(xte::uz)>& function) {
+			if (count <= 1) {
+				if (count) {
+					function(0);
+				}
+				return;
+			}
+			struct job {
+				const std::function<void(xte::uz)>* function;
+				std::vector<std::atomic<xte::u64>> slices;
+				std::atomic<xte::uz> joined = 0;
+				std::atomic<xte::uz> remaining;
+				std::mutex mutex;
+				std::condition_variable done;
+			};
+			const xte::uz participants = std::min(count, this->threads.size() + 1);
+			auto state = std::make_shared<job>(&function, std::vector<std::atomic<xte::u64>>(participants));
+			state->remaining = count;
+			for (xte::uz i = 0; i < participants; ++i) {
+				state->slices[i] = sand::thread_pool::slice(count * i / participants, count * (i + 1) / participants);
+			}
+			auto run = [state] -> void {
+				const xte::uz self = state->joined++;
+				auto finish = [&](xte::uz i) -> void {
+					(*state->function)(i);
+					if (!--state->remaining) {
+						auto lock = std::lock_guard(state->mutex);
+						state->done.notify_all();
+					}
+				};
+				while (true) {
+					for (xte::uz i; sand::thread_pool::take_front(state->slices[self], i);) {
+						finish(i);
+					}
+					bool stole = false;
+					for (xte::uz offset = 1; !stole && (offset < state->slices.size()); ++offset) {
+						stole = sand::thread_pool::steal_back(state->slices[(self + offset) % state->slices.size()], state->slices[self]);
+					}
+					if (!stole) {
+						return;
+					}
+				}
+			};
+			{
+				auto lock = std::lock_guard(this->mutex);
+				for (xte::uz i = participants - 1; i--;) {
+					this->tasks.emplace_back(run);
+				}
+			}
+			this->signal.notify_all();
+			run();
+			auto lock = std::unique_lock(state->mutex);
+			state->done.wait(lock, [&] -> bool {
+				return !state->remaining;
+			});
+		}
+
+		// A slice packs its begin into the low half and its end into the high half, so it can be shrunk from either side atomically
+		[[nodiscard]] static constexpr xte::u64 slice(xte::uz begin, xte::uz end) noexcept {
+			return static_cast<xte::u64>(begin) | (static_cast<xte::u64>(end) << 32);
+		}
+
+		[[nodiscard]] static bool take_front(std::atomic<xte::u64>& slice, xte::uz& i) noexcept {
+			for (xte::u64 bounds = slice.load(); true;) {
+				const xte::uz begin = bounds & 0xFFFFFFFF;
+				const xte::uz end = bounds >> 32;
+				if (begin >= end) {
+					return false;
+				}
+				if (slice.compare_exchange_weak(bounds, sand::thread_pool::slice(begin + 1, end))) {
+					i = begin;
+					return true;
+				}
+			}
+		}
+
+		[[nodiscard]] static bool steal_back(std::atomic<xte::u64>& victim, std::atomic<xte::u64>& own) noexcept {
+			for (xte::u64 bounds = victim.load(); true;) {
+				const xte::uz begin = bounds & 0xFFFFFFFF;
+				const xte::uz end = bounds >> 32;
+				if (begin >= end) {
+					return false;
+				}
+				const xte::uz middle = begin + (end - begin) / 2;
+				if (victim.compare_exchange_weak(bounds, sand::thread_pool::slice(begin, middle))) {
+					own = sand::thread_pool::slice(middle, end);
+					return true;
+				}
+			}
+		}
+	};
+
+	inline sand::thread_pool workers(std::max(std::thread::hardware_concurrency(), 1u));
+}
+
+#endif
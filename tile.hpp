@@ -6,10 +6,33 @@
 #	include <meta>
 
 namespace sand {
+	using tile_id = xte::u8;
+
+	enum class tile_motion {
+		fixed,
+		granular,
+		fluid
+	};
+
+	enum class conveyor_dir {
+		none,
+		right,
+		left,
+		up,
+		down
+	};
+
+	[[nodiscard]] constexpr bool conveyor_vertical(sand::conveyor_dir dir) noexcept {
+		return (dir == sand::conveyor_dir::up) || (dir == sand::conveyor_dir::down);
+	}
+
 	struct tile {
 		xte::u64 texture_index = 0x00;
 		bool background = false;
 		bool transparent = false;
+		sand::tile_motion motion = sand::tile_motion::fixed;
+		sand::conveyor_dir conveyor = sand::conveyor_dir::none;
+		xte::u8 light = 0;
 
 		[[nodiscard]] friend constexpr bool operator==(const sand::tile& lhs, const sand::tile& rhs) noexcept {
 			return lhs.texture_index == rhs.texture_index;
@@ -22,7 +45,7 @@ namespace sand {
 		/* 0x02: cobbled stone */  { 0x02 },
 		/* 0x03: dark blue */      { 0x03, true },
 		/* 0x04: light blue */     { 0x04, true },
-		/* 0x05: rainbow */        { 0x05 },
+		/* 0x05: rainbow */        { 0x05, false, false, sand::tile_motion::fixed, sand::conveyor_dir::none, 0xF },
 		/* 0x06: dirt */           { 0x06 },
 		/* 0x07: rock */           { 0x07 },
 		/* 0x08: leaves */         { 0x08 },
@@ -35,10 +58,12 @@ namespace sand {
 		/* 0x0F: wood planks */    { 0x1C },
 		/* 0x10: stone bricks */   { 0x1D },
 		/* 0x11: glass */          { 0x1E, false, true },
-		/* 0x12: conveyor right */ { 0x1F },
-		/* 0x13: conveyor right */ { 0x20 },
-		/* 0x14: conveyor up */    { 0x21 },
-		/* 0x15: conveyor down */  { 0x22 }
+		/* 0x12: conveyor right */ { 0x1F, false, false, sand::tile_motion::fixed, sand::conveyor_dir::right },
+		/* 0x13: conveyor left */  { 0x20, false, false, sand::tile_motion::fixed, sand::conveyor_dir::left },
+		/* 0x14: conveyor up */    { 0x21, false, false, sand::tile_motion::fixed, sand::conveyor_dir::up },
+		/* 0x15: conveyor down */  { 0x22, false, false, sand::tile_motion::fixed, sand::conveyor_dir::down },
+		/* 0x16: sand */           { 0x23, false, false, sand::tile_motion::granular },
+		/* 0x17: water */          { 0x24, true, false, sand::tile_motion::fluid }
 	});
 }
 
@@ -0,0 +1,598 @@
+#ifndef SAND_HEADER_WORLD
+#	define SAND_HEADER_WORLD
+#
+#	include "animation.hpp"
+#	include "chunk.hpp"
+#	include "chunk_codec.hpp"
+#	include "mip.hpp"
+#	include "occupancy.hpp"
+#	include "pos.hpp"
+#	include "save.hpp"
+#	include "saver.hpp"
+#	include "thread_pool.hpp"
+#	include "tile.hpp"
+#	include "world_file.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <algorithm>
+#	include <list>
+#	include <memory>
+#	include <span>
+#	include <string>
+#	include <unordered_map>
+#	include <unordered_set>
+#	include <utility>
+#	include <vector>
+
+namespace sand {
+	struct world_chunk {
+		mutable std::shared_ptr<sand::chunk> data;
+		mutable std::vector<xte::u8> packed;
+		std::shared_ptr<sand::chunk_state> state;
+		std::unique_ptr<sand::light_map> light;
+		std::unique_ptr<sand::chunk_mip> mip;
+		sand::tile_histogram histogram;
+		bool dirty = true;
+		bool incompressible = false;
+		bool state_changed = false;
+		xte::u64 accessed = 0;
+		xte::u64 version = 0;
+		// The tick of the stored copy this chunk was loaded from, and for mapped chunks where edits record their tick
+		xte::u64 stored_tick = 0;
+		xte::u64* mapped_tick = nullptr;
+		sand::tile_mask changed;
+		sand::tile_mask active;
+		sand::tile_mask stepping;
+		sand::tile_mask conveying;
+		sand::tile_mask animated;
+		std::list<sand::chunk_pos>::iterator recent;
+
+		void thaw() const {
+			if (!this->data) {
+				this->data = std::make_shared<sand::chunk>(sand::unpack_chunk(this->packed));
+				this->packed = {};
+			}
+		}
+
+		[[nodiscard]] const sand::chunk& tiles() const {
+			this->thaw();
+			return *this->data;
+		}
+
+		// Clones the tiles if a snapshot still shares them, so references must not be held across `sand::save_world`
+		// Mapped tiles have no owner and are always edited in place
+		[[nodiscard]] sand::chunk& edit() {
+			this->thaw();
+			this->incompressible = false;
+			if (this->data.use_count() > 1) {
+				this->data = std::make_shared<sand::chunk>(*this->data);
+			}
+			return *this->data;
+		}
+
+		// Chunks stay without a light map until something lights them
+		[[nodiscard]] xte::u8 light_at(xte::uz index) const noexcept {
+			return this->light ? (*this->light)[index] : 0;
+		}
+
+		void set_light(xte::uz index, xte::u8 level) {
+			if (!this->light) {
+				if (!level) {
+					return;
+				}
+				this->light = std::make_unique<sand::light_map>();
+			}
+			(*this->light)[index] = level;
+		}
+
+		// Built on the first zoomed out draw, and kept current by `sand::set_tile` from then on
+		[[nodiscard]] const sand::chunk_mip& summary() {
+			if (!this->mip) {
+				this->mip = std::make_unique<sand::chunk_mip>(sand::build_mip(this->tiles()));
+			}
+			return *this->mip;
+		}
+
+		// Zero means no state, and a chunk left with none frees its state entirely
+		[[nodiscard]] xte::u32 state_at(xte::uz index) const noexcept {
+			if (!this->state) {
+				return 0;
+			}
+			const auto iter = std::ranges::lower_bound(*this->state, index, {}, &sand::tile_state::index);
+			return ((iter != this->state->end()) && (iter->index == index)) ? iter->value : 0;
+		}
+
+		// Shared with snapshots like the tiles, so it is cloned before the first change after a save
+		void set_state(xte::uz index, xte::u32 value) {
+			if (this->state_at(index) == value) {
+				return;
+			}
+			if (!this->state) {
+				this->state = std::make_shared<sand::chunk_state>();
+			} else if (this->state.use_count() > 1) {
+				this->state = std::make_shared<sand::chunk_state>(*this->state);
+			}
+			const auto iter = std::ranges::lower_bound(*this->state, index, {}, &sand::tile_state::index);
+			if ((iter != this->state->end()) && (iter->index == index)) {
+				if (value) {
+					iter->value = value;
+				} else {
+					this->state->erase(iter);
+				}
+			} else {
+				this->state->insert(iter, { static_cast<xte::u16>(index), value });
+			}
+			if (this->state->empty()) {
+				this->state.reset();
+			}
+			this->dirty = true;
+			this->state_changed = true;
+		}
+	};
+
+	struct tile_change {
+		sand::pos pos;
+		sand::tile_id old_id;
+		sand::tile_id new_id;
+	};
+
+	struct world_memory {
+		xte::uz hot_chunks = 0;
+		xte::uz cold_chunks = 0;
+		xte::uz cold_bytes = 0;
+		xte::uz shared_chunks = 0;
+		xte::uz shared_bytes = 0;
+	};
+
+	inline xte::u64 tick = 0;
+
+	inline xte::u64 chunk_budget = 0x400;
+	inline constexpr xte::u64 cold_ticks = 0x200;
+	inline constexpr xte::u64 freeze_interval = 0x40;
+
+	// Versions come from one counter, so a chunk reloaded after eviction never repeats an earlier version
+	inline xte::u64 world_version = 0;
+	inline std::vector<sand::tile_change> tile_changes;
+
+	// Belts whose carried tile changed without their own tile changing, so they can be drawn again
+	inline std::vector<sand::pos> carry_changes;
+
+	inline std::unordered_map<sand::chunk_pos, sand::world_chunk, sand::chunk_pos_hash> world;
+	inline std::list<sand::chunk_pos> recent_chunks;
+	inline std::unordered_set<sand::chunk_pos, sand::chunk_pos_hash> awake_chunks;
+	inline std::unordered_set<sand::chunk_pos, sand::chunk_pos_hash> conveyor_chunks;
+	inline std::vector<sand::chunk_pos> inserted_chunks;
+
+	// Positions with no chunk file, so views that pass over unexplored space do not ask the filesystem again every frame
+	// A chunk file is only ever written for a resident chunk, so inserting one forgets its position here
+	inline std::unordered_set<sand::chunk_pos, sand::chunk_pos_hash> absent_chunks;
+
+	inline xte::fixed_array<std::shared_ptr<sand::chunk>, 0x100> uniform_chunks;
+	inline std::unordered_map<xte::u64, std::weak_ptr<sand::chunk>> interned_chunks;
+
+	// Shared chunks are never edited in place, so a sentinel or interned copy is promoted on its first write
+	[[nodiscard]] inline std::shared_ptr<sand::chunk> uniform_chunk(sand::tile_id tile) {
+		auto& chunk = sand::uniform_chunks[tile];
+		if (!chunk) {
+			chunk = std::make_shared<sand::chunk>();
+			chunk->data.fill(tile);
+		}
+		return chunk;
+	}
+
+	[[nodiscard]] inline std::shared_ptr<sand::chunk> intern_chunk(std::shared_ptr<sand::chunk> data) {
+		if (sand::chunk_uniform(*data)) {
+			return sand::uniform_chunk(data->at(0, 0));
+		}
+		auto& interned = sand::interned_chunks[sand::chunk_hash(*data)];
+		if (auto existing = interned.lock(); existing && (*existing == *data)) {
+			return existing;
+		}
+		interned = data;
+		return data;
+	}
+
+	inline void touch_chunk(sand::world_chunk& chunk) noexcept {
+		chunk.accessed = sand::tick;
+		sand::recent_chunks.splice(sand::recent_chunks.begin(), sand::recent_chunks, chunk.recent);
+	}
+
+	// Neighborhoods are reached without `sand::load_chunk`, so the simulation touches them itself to keep them from being frozen or evicted while in use
+	inline void touch_around(const sand::chunk_pos& pos) {
+		for (xte::u64 i = 0; i < 9; ++i) {
+			if (const auto iter = sand::world.find({ pos.x + i % 3 - 1, pos.y + i / 3 - 1 }); iter != sand::world.end()) {
+				sand::touch_chunk(iter->second);
+			}
+		}
+	}
+
+	// Only moving tiles and conveyors are woken, and only in resident chunks
+	inline void wake_tile(const sand::pos& pos) {
+		const auto iter = sand::world.find(sand::chunk_of(pos));
+		if (iter == sand::world.end()) {
+			return;
+		}
+		auto& chunk = iter->second;
+		const sand::tile& tile = sand::tiles[chunk.tiles().at(pos.tile_x, pos.tile_y)];
+		if (tile.motion != sand::tile_motion::fixed) {
+			chunk.active.set(sand::tile_index(pos));
+			sand::awake_chunks.insert(iter->first);
+		} else if (tile.conveyor != sand::conveyor_dir::none) {
+			chunk.conveying.set(sand::tile_index(pos));
+			sand::conveyor_chunks.insert(iter->first);
+		}
+	}
+
+	inline void wake_around(const sand::pos& pos) {
+		const sand::pos corner = pos - sand::pos(0, 0, 1, 1);
+		for (xte::u64 y = 0; y < 3; ++y) {
+			for (xte::u64 x = 0; x < 3; ++x) {
+				sand::wake_tile(corner + sand::pos(0, 0, x, y));
+			}
+		}
+	}
+
+	// Wakes every moving tile in a chunk, and the edge tiles of its neighbors that could now move into it
+	inline void wake_chunk(const sand::chunk_pos& pos) {
+		const sand::pos origin = sand::pos(pos.x, pos.y, 0, 0);
+		for (xte::u64 tile_y = 0; tile_y < sand::chunk_h; ++tile_y) {
+			sand::wake_tile(origin - sand::pos(0, 0, 1, 0) + sand::pos(0, 0, 0, tile_y));
+			for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+				sand::wake_tile(origin + sand::pos(0, 0, tile_x, tile_y));
+			}
+			sand::wake_tile(origin + sand::pos(0, 0, sand::chunk_w, tile_y));
+		}
+		sand::wake_tile(origin - sand::pos(0, 0, 1, 0) + sand::pos(0, 0, 0, sand::chunk_h));
+		for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+			sand::wake_tile(origin + sand::pos(0, 0, tile_x, sand::chunk_h));
+		}
+		sand::wake_tile(origin + sand::pos(0, 0, sand::chunk_w, sand::chunk_h));
+	}
+
+	// Must not run while chunks are being stepped in parallel
+	inline void refresh_occupancy(const sand::chunk_pos& pos, const sand::world_chunk& chunk) {
+		sand::set_occupancy(pos, { 1, chunk.histogram.empty(), chunk.histogram.uniform(), chunk.dirty });
+	}
+
+	inline sand::world_chunk& insert_chunk(const sand::chunk_pos& pos, std::shared_ptr<sand::chunk> data, const sand::tile_histogram& histogram, std::shared_ptr<sand::chunk_state> state, bool dirty) {
+		auto& chunk = sand::world[pos];
+		chunk.data = std::move(data);
+		chunk.histogram = histogram;
+		chunk.animated = sand::animated_tiles(*chunk.data, histogram);
+		chunk.state = std::move(state);
+		chunk.dirty = dirty;
+		chunk.accessed = sand::tick;
+		chunk.version = ++sand::world_version;
+		chunk.recent = sand::recent_chunks.insert(sand::recent_chunks.begin(), pos);
+		sand::inserted_chunks.push_back(pos);
+		sand::absent_chunks.erase(pos);
+		sand::refresh_occupancy(pos, chunk);
+		sand::wake_chunk(pos);
+		return chunk;
+	}
+
+	// Only looks at resident chunks, never loading, creating or reordering them
+	[[nodiscard]] inline sand::world_chunk* find_chunk(const sand::chunk_pos& pos) {
+		const auto iter = sand::world.find(pos);
+		return (iter != sand::world.end()) ? &iter->second : nullptr;
+	}
+
+	[[nodiscard]] inline const sand::tile_id* find_tile(const sand::pos& pos) {
+		const auto* chunk = sand::find_chunk(sand::chunk_of(pos));
+		return chunk ? &chunk->tiles().at(pos.tile_x, pos.tile_y) : nullptr;
+	}
+
+	// Remembers the last chunk looked up, and must not outlive a call to `sand::evict_chunks`
+	struct chunk_cursor {
+		sand::chunk_pos pos = { 0, 0 };
+		const sand::world_chunk* chunk = nullptr;
+		bool cached = false;
+
+		[[nodiscard]] const sand::world_chunk* find(const sand::chunk_pos& pos) {
+			if (!this->cached || (this->pos != pos)) {
+				this->pos = pos;
+				this->chunk = sand::find_chunk(pos);
+				this->cached = true;
+			}
+			return this->chunk;
+		}
+
+		[[nodiscard]] const sand::tile_id* find_tile(const sand::pos& pos) {
+			const auto* chunk = this->find(sand::chunk_of(pos));
+			return chunk ? &chunk->tiles().at(pos.tile_x, pos.tile_y) : nullptr;
+		}
+	};
+
+	[[nodiscard]] inline std::shared_ptr<sand::chunk> mapped_data(sand::chunk& tiles) noexcept {
+		return std::shared_ptr<sand::chunk>(std::shared_ptr<sand::chunk>(), &tiles);
+	}
+
+	[[nodiscard]] inline sand::world_chunk* load_chunk(const sand::chunk_pos& pos) {
+		if (const auto iter = sand::world.find(pos); iter != sand::world.end()) {
+			sand::touch_chunk(iter->second);
+			return &iter->second;
+		}
+		if (sand::store == sand::store_mode::mapped) {
+			sand::world_file_slot* slot = sand::find_mapped(pos);
+			if (!slot) {
+				if (sand::absent_chunks.contains(pos)) {
+					return nullptr;
+				}
+				sand::chunk imported;
+				sand::tile_histogram imported_histogram;
+				sand::chunk_state imported_state;
+				xte::u64 imported_tick;
+				if (!sand::read_chunk(pos, imported, imported_histogram, imported_state, imported_tick)) {
+					sand::absent_chunks.insert(pos);
+					return nullptr;
+				}
+				slot = &sand::insert_mapped(pos);
+				slot->tiles = imported;
+				slot->histogram = imported_histogram;
+				slot->tick = imported_tick;
+				sand::store_mapped_state(*slot, imported_state.empty() ? nullptr : &imported_state);
+			} else {
+				// Tiles are written in place but the histogram only on save, so after a crash it can be stale
+				slot->histogram = sand::count_tiles(slot->tiles);
+			}
+			auto& chunk = sand::insert_chunk(pos, sand::mapped_data(slot->tiles), slot->histogram, sand::load_mapped_state(*slot), false);
+			chunk.stored_tick = slot->tick;
+			chunk.mapped_tick = &slot->tick;
+			return &chunk;
+		}
+		sand::saved_chunk pending = sand::find_pending(pos);
+		if (!pending.data) {
+			if (sand::absent_chunks.contains(pos)) {
+				return nullptr;
+			}
+			pending.data = std::make_shared<sand::chunk>();
+			sand::chunk_state state;
+			if (!sand::read_chunk(pos, *pending.data, pending.histogram, state, pending.tick)) {
+				sand::absent_chunks.insert(pos);
+				return nullptr;
+			}
+			pending.data = sand::intern_chunk(std::move(pending.data));
+			if (!state.empty()) {
+				pending.state = std::make_shared<sand::chunk_state>(std::move(state));
+			}
+		}
+		auto& chunk = sand::insert_chunk(pos, std::move(pending.data), pending.histogram, std::move(pending.state), false);
+		chunk.stored_tick = pending.tick;
+		return &chunk;
+	}
+
+	// Reads missing chunks on the worker pool, then inserts them together
+	inline void load_chunks(std::span<const sand::chunk_pos> positions) {
+		if (sand::store == sand::store_mode::mapped) {
+			return;
+		}
+		std::unordered_set<sand::chunk_pos, sand::chunk_pos_hash> seen;
+		std::vector<sand::chunk_pos> missing;
+		for (auto&& pos : positions) {
+			if (sand::world.contains(pos) || !seen.insert(pos).second) {
+				continue;
+			}
+			if (sand::saved_chunk pending = sand::find_pending(pos); pending.data) {
+				sand::insert_chunk(pos, std::move(pending.data), pending.histogram, std::move(pending.state), false).stored_tick = pending.tick;
+			} else if (!sand::absent_chunks.contains(pos)) {
+				missing.push_back(pos);
+			}
+		}
+		std::vector<sand::saved_chunk> loaded(missing.size());
+		sand::workers.parallel_for(missing.size(), [&](xte::uz i) -> void {
+			auto data = std::make_shared<sand::chunk>();
+			sand::tile_histogram histogram;
+			sand::chunk_state state;
+			xte::u64 tick;
+			if (sand::read_chunk(missing[i], *data, histogram, state, tick)) {
+				loaded[i] = { missing[i], std::move(data), state.empty() ? nullptr : std::make_shared<sand::chunk_state>(std::move(state)), histogram, tick };
+			}
+		});
+		for (xte::uz i = 0; i < loaded.size(); ++i) {
+			if (auto& chunk = loaded[i]; chunk.data) {
+				sand::insert_chunk(chunk.pos, sand::intern_chunk(std::move(chunk.data)), chunk.histogram, std::move(chunk.state), false).stored_tick = chunk.tick;
+			} else {
+				sand::absent_chunks.insert(missing[i]);
+			}
+		}
+	}
+
+	inline sand::world_chunk& create_chunk(const sand::chunk_pos& pos) {
+		if (sand::store == sand::store_mode::mapped) {
+			auto& slot = sand::insert_mapped(pos);
+			auto& chunk = sand::insert_chunk(pos, sand::mapped_data(slot.tiles), {}, nullptr, false);
+			chunk.mapped_tick = &slot.tick;
+			return chunk;
+		}
+		return sand::insert_chunk(pos, sand::uniform_chunk(0x00), {}, nullptr, true);
+	}
+
+	[[nodiscard]] inline sand::world_chunk& chunk_at(const sand::chunk_pos& pos) {
+		if (auto* chunk = sand::load_chunk(pos)) {
+			return *chunk;
+		}
+		return sand::create_chunk(pos);
+	}
+
+	// Touches only `chunk` and `changes`, so chunks can be written from different threads into separate lists
+	// The caller merges `changes` into `sand::tile_changes` and gives the chunk a new version afterwards
+	// A vertical belt's state is the tile it carries, which is left where the belt stood when it is removed, and keeps anything else from replacing it
+	inline bool set_tile(sand::world_chunk& chunk, const sand::pos& pos, sand::tile_id tile, std::vector<sand::tile_change>& changes) {
+		const sand::tile_id old_id = chunk.tiles().at(pos.tile_x, pos.tile_y);
+		if (const xte::u32 carried = sand::conveyor_vertical(sand::tiles[old_id].conveyor) ? chunk.state_at(sand::tile_index(pos)) : 0; carried && (carried < sand::tiles.size())) {
+			if (tile) {
+				return false;
+			}
+			tile = static_cast<sand::tile_id>(carried);
+		}
+		if (old_id == tile) {
+			return false;
+		}
+		chunk.edit().at(pos.tile_x, pos.tile_y) = tile;
+		chunk.histogram.remove(old_id);
+		chunk.histogram.add(tile);
+		if (chunk.mip) {
+			chunk.mip->remove(pos.tile_x, pos.tile_y, old_id);
+			chunk.mip->add(pos.tile_x, pos.tile_y, tile);
+		}
+		chunk.dirty = true;
+		chunk.changed.set(sand::tile_index(pos));
+		if (sand::tile_animated[tile]) {
+			chunk.animated.set(sand::tile_index(pos));
+		} else {
+			chunk.animated.reset(sand::tile_index(pos));
+		}
+		if (chunk.state) {
+			chunk.set_state(sand::tile_index(pos), 0);
+		}
+		if (chunk.mapped_tick) {
+			*chunk.mapped_tick = sand::tick;
+		}
+		changes.push_back({ pos, old_id, tile });
+		return true;
+	}
+
+	// Every single-tile write goes through here, so versions, changed bits and the change queue stay complete
+	inline bool set_tile(sand::world_chunk& chunk, const sand::pos& pos, sand::tile_id tile) {
+		if (!sand::set_tile(chunk, pos, tile, sand::tile_changes)) {
+			return false;
+		}
+		chunk.version = ++sand::world_version;
+		return true;
+	}
+
+	inline bool set_tile(const sand::pos& pos, sand::tile_id tile) {
+		return sand::set_tile(sand::chunk_at(sand::chunk_of(pos)), pos, tile);
+	}
+
+	// Every tile change is in the queue, and chunks whose state alone changed keep a belt awake
+	inline void update_occupancy() {
+		for (auto&& change : sand::tile_changes) {
+			if (const auto* chunk = sand::find_chunk(sand::chunk_of(change.pos))) {
+				sand::refresh_occupancy(sand::chunk_of(change.pos), *chunk);
+			}
+		}
+		for (auto&& pos : sand::conveyor_chunks) {
+			sand::refresh_occupancy(pos, sand::world.at(pos));
+		}
+	}
+
+	// Consumers read `sand::tile_changes` and `sand::inserted_chunks` during a tick, then this forgets them
+	inline void clear_tile_changes() {
+		for (auto&& change : sand::tile_changes) {
+			if (const auto iter = sand::world.find(sand::chunk_of(change.pos)); iter != sand::world.end()) {
+				iter->second.changed.reset();
+			}
+		}
+		sand::tile_changes.clear();
+		sand::carry_changes.clear();
+		sand::inserted_chunks.clear();
+	}
+
+	// Mapped tiles are already in the file, so only the histogram and state are written back
+	inline void store_mapped(const sand::chunk_pos& pos, sand::world_chunk& chunk) {
+		auto& slot = *sand::find_mapped(pos);
+		if (chunk.dirty) {
+			slot.histogram = chunk.histogram;
+			chunk.dirty = false;
+		}
+		if (chunk.state_changed) {
+			sand::store_mapped_state(slot, chunk.state.get());
+			chunk.state_changed = false;
+		}
+		sand::refresh_occupancy(pos, chunk);
+	}
+
+	inline void evict_chunks() {
+		sand::save_batch batch;
+		while (sand::world.size() > sand::chunk_budget) {
+			const sand::chunk_pos pos = sand::recent_chunks.back();
+			if (auto& chunk = sand::world.at(pos); chunk.dirty && (sand::store == sand::store_mode::files)) {
+				batch.chunks.emplace_back(pos, std::move(chunk.data), std::move(chunk.state), chunk.histogram, sand::tick);
+			} else if (sand::store == sand::store_mode::mapped) {
+				sand::store_mapped(pos, chunk);
+			}
+			sand::set_occupancy(pos, {});
+			sand::world.erase(pos);
+			sand::recent_chunks.pop_back();
+			sand::awake_chunks.erase(pos);
+			sand::conveyor_chunks.erase(pos);
+		}
+		if (sand::interned_chunks.size() > (sand::chunk_budget * 2)) {
+			std::erase_if(sand::interned_chunks, [](const auto& interned) -> bool {
+				return interned.second.expired();
+			});
+		}
+		sand::queue_save(std::move(batch));
+	}
+
+	// Packs clean private chunks that have gone unused, starting from the least recently used
+	inline void freeze_chunks() {
+		for (auto pos = sand::recent_chunks.rbegin(); pos != sand::recent_chunks.rend(); ++pos) {
+			auto& chunk = sand::world.at(*pos);
+			if ((sand::tick - chunk.accessed) < sand::cold_ticks) {
+				break;
+			}
+			if (chunk.data && !chunk.dirty && !chunk.incompressible && (chunk.data.use_count() == 1) && !sand::awake_chunks.contains(*pos) && !sand::conveyor_chunks.contains(*pos)) {
+				if (std::vector<xte::u8> packed = sand::pack_chunk(*chunk.data); packed.empty()) {
+					chunk.incompressible = true;
+				} else {
+					chunk.packed = std::move(packed);
+					chunk.data.reset();
+				}
+			}
+		}
+	}
+
+	[[nodiscard]] inline sand::world_memory measure_world() {
+		sand::world_memory memory;
+		std::unordered_set<const sand::chunk*> shared;
+		for (auto&& [pos, chunk] : sand::world) {
+			if (!chunk.data) {
+				++memory.cold_chunks;
+				memory.cold_bytes += chunk.packed.capacity();
+			} else if (chunk.data.use_count() > 1) {
+				++memory.shared_chunks;
+				shared.insert(chunk.data.get());
+			} else {
+				++memory.hot_chunks;
+			}
+		}
+		memory.shared_bytes = shared.size() * sizeof(sand::chunk);
+		return memory;
+	}
+
+	// `tick` is the last tick whose edits are all made, and each saved chunk is stamped with it
+	inline void save_world(xte::u64 tick, std::string index, std::vector<std::string> retired = {}) {
+		sand::save_batch batch;
+		batch.index = std::move(index);
+		batch.retired = std::move(retired);
+		sand::update_occupancy();
+		const std::vector<sand::chunk_pos> dirty = sand::find_chunks([](const sand::occupancy_node& node) -> bool {
+			return node.dirty;
+		});
+		if (sand::store == sand::store_mode::mapped) {
+			for (auto&& pos : dirty) {
+				sand::store_mapped(pos, sand::world.at(pos));
+			}
+			batch.sync_mapped = true;
+		} else {
+			// Only uniform chunks, which the histogram finds without a scan, are shared here; identical chunks are shared on disk by the writer and in memory when loaded
+			for (auto&& pos : dirty) {
+				auto& chunk = sand::world.at(pos);
+				if (chunk.histogram.uniform()) {
+					chunk.data = sand::uniform_chunk(chunk.data->at(0, 0));
+				}
+				batch.chunks.emplace_back(pos, chunk.data, chunk.state, chunk.histogram, tick);
+				chunk.dirty = false;
+				chunk.state_changed = false;
+				sand::refresh_occupancy(pos, chunk);
+			}
+		}
+		sand::queue_save(std::move(batch));
+	}
+}
+
+#endif
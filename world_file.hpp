@@ -0,0 +1,166 @@
+#ifndef SAND_HEADER_WORLD_FILE
+#	define SAND_HEADER_WORLD_FILE
+#
+#	include "chunk.hpp"
+#	include "log.hpp"
+#	include "save.hpp"
+#
+#	include <xte/data/fixed_array.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#
+#	include <algorithm>
+#	include <cstddef>
+#	include <cstring>
+#	include <filesystem>
+#	include <format>
+#	include <memory>
+#	include <string>
+
+namespace sand {
+	struct world_file_header {
+		char magic[8];
+		xte::u64 slots;
+	};
+
+	struct world_file_entry {
+		xte::u64 x;
+		xte::u64 y;
+		xte::u64 slot;
+	};
+
+	// The state area is only written for chunks with stateful tiles, so elsewhere it stays a hole in the file
+	// Tiles are edited in place, but the histogram is only copied back on save and eviction
+	// The tick is the last one whose edits the tiles hold, and is written with them so the kernel never flushes one without the other
+	struct world_file_slot {
+		sand::chunk tiles;
+		sand::tile_histogram histogram;
+		xte::u64 tick;
+		xte::u64 state_count;
+		xte::fixed_array<sand::tile_state, sand::chunk_w * sand::chunk_h> state;
+	};
+
+	// header page, open-addressed chunk table, then one fixed-size slot per chunk
+	inline constexpr xte::uz world_file_entries = 0x100000;
+	inline constexpr xte::uz world_file_table = 0x1000;
+	inline constexpr xte::uz world_file_slots = sand::world_file_table + sand::world_file_entries * sizeof(sand::world_file_entry);
+	inline constexpr xte::uz world_file_growth = 0x400 * sizeof(sand::world_file_slot);
+	inline constexpr xte::uz world_file_reserve = sand::world_file_slots + sand::world_file_entries * sizeof(sand::world_file_slot);
+	inline constexpr char world_file_magic[8] = { 's', 'a', 'n', 'd', 'w', 'l', 'd', '5' };
+
+	inline int world_file_fd = -1;
+	inline std::byte* world_file_base = nullptr;
+	inline xte::uz world_file_size = 0;
+
+	[[nodiscard]] inline std::string world_file_path() {
+		return std::format("{}/world.bin", sand::save_dir);
+	}
+
+	[[nodiscard]] inline sand::world_file_header& mapped_header() noexcept {
+		return *reinterpret_cast<sand::world_file_header*>(sand::world_file_base);
+	}
+
+	[[nodiscard]] inline sand::world_file_entry* mapped_table() noexcept {
+		return reinterpret_cast<sand::world_file_entry*>(sand::world_file_base + sand::world_file_table);
+	}
+
+	// The whole file is reserved up front so chunk pointers stay valid as it grows
+	inline void grow_world_file(xte::uz size) {
+		if (::ftruncate(sand::world_file_fd, static_cast<::off_t>(size))
+			|| (::mmap(sand::world_file_base + sand::world_file_size, size - sand::world_file_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, sand::world_file_fd, static_cast<::off_t>(sand::world_file_size)) == MAP_FAILED)) {
+			sand::log("failed to grow world file");
+			throw;
+		}
+		sand::world_file_size = size;
+	}
+
+	inline void open_world_file() {
+		std::filesystem::create_directories(std::format("{}", sand::save_dir));
+		sand::world_file_fd = ::open(sand::world_file_path().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		void* base = ::mmap(nullptr, sand::world_file_reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		struct ::stat status;
+		if ((sand::world_file_fd < 0) || (base == MAP_FAILED) || ::fstat(sand::world_file_fd, &status)) {
+			sand::log("failed to open world file");
+			throw;
+		}
+		sand::world_file_base = static_cast<std::byte*>(base);
+		if (status.st_size) {
+			sand::grow_world_file(static_cast<xte::uz>(status.st_size));
+			if (std::memcmp(sand::mapped_header().magic, sand::world_file_magic, sizeof(sand::world_file_magic))) {
+				sand::log("invalid world file");
+				throw;
+			}
+		} else {
+			sand::grow_world_file(sand::world_file_slots + sand::world_file_growth);
+			std::memcpy(sand::mapped_header().magic, sand::world_file_magic, sizeof(sand::world_file_magic));
+		}
+	}
+
+	inline void sync_world_file(bool wait) {
+		::msync(sand::world_file_base, sand::world_file_size, wait ? MS_SYNC : MS_ASYNC);
+	}
+
+	inline void close_world_file() {
+		sand::sync_world_file(true);
+		::munmap(sand::world_file_base, sand::world_file_reserve);
+		::close(sand::world_file_fd);
+	}
+
+	[[nodiscard]] inline sand::world_file_slot& mapped_slot(xte::u64 slot) noexcept {
+		return *reinterpret_cast<sand::world_file_slot*>(sand::world_file_base + sand::world_file_slots + (slot - 1) * sizeof(sand::world_file_slot));
+	}
+
+	[[nodiscard]] inline sand::world_file_entry& mapped_entry(const sand::chunk_pos& pos) noexcept {
+		sand::world_file_entry* table = sand::mapped_table();
+		for (xte::uz i = sand::chunk_pos_hash()(pos);; ++i) {
+			auto& entry = table[i % sand::world_file_entries];
+			if (!entry.slot || ((entry.x == pos.x) && (entry.y == pos.y))) {
+				return entry;
+			}
+		}
+	}
+
+	[[nodiscard]] inline sand::world_file_slot* find_mapped(const sand::chunk_pos& pos) noexcept {
+		const auto& entry = sand::mapped_entry(pos);
+		return entry.slot ? &sand::mapped_slot(entry.slot) : nullptr;
+	}
+
+	// New slots read as all void because the file is extended with zeros
+	[[nodiscard]] inline sand::world_file_slot& insert_mapped(const sand::chunk_pos& pos) {
+		auto& header = sand::mapped_header();
+		if ((header.slots + 1) >= sand::world_file_entries) {
+			sand::log("world file is full");
+			throw;
+		}
+		auto& entry = sand::mapped_entry(pos);
+		entry = { pos.x, pos.y, ++header.slots };
+		if ((sand::world_file_slots + header.slots * sizeof(sand::world_file_slot)) > sand::world_file_size) {
+			sand::grow_world_file(sand::world_file_size + sand::world_file_growth);
+		}
+		return sand::mapped_slot(entry.slot);
+	}
+
+	[[nodiscard]] inline std::shared_ptr<sand::chunk_state> load_mapped_state(const sand::world_file_slot& slot) {
+		if (!slot.state_count) {
+			return nullptr;
+		}
+		return std::make_shared<sand::chunk_state>(slot.state.begin(), slot.state.begin() + static_cast<std::ptrdiff_t>(slot.state_count));
+	}
+
+	inline void store_mapped_state(sand::world_file_slot& slot, const sand::chunk_state* state) {
+		if (!state) {
+			if (slot.state_count) {
+				slot.state_count = 0;
+			}
+			return;
+		}
+		std::ranges::copy(*state, slot.state.begin());
+		slot.state_count = state->size();
+	}
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SAND_HEADER_WORLDGEN
+#	define SAND_HEADER_WORLDGEN
+#
+#	include "chunk.hpp"
+#	include "tile.hpp"
+#	include "world.hpp"
+#
+#	include <xte/math/less.hpp>
+#	include <xte/util/number_types.hpp>
+#
+#	include <random>
+
+namespace sand {
+	inline sand::world_chunk& generate_chunk(const sand::chunk_pos& pos, std::mt19937& rng) {
+		auto& world_chunk = sand::create_chunk(pos);
+		auto& chunk = world_chunk.edit();
+		if (std::uniform_int_distribution<xte::u64>(0, 63)(rng)) {
+			sand::chunk_cursor cursor;
+			auto empty = [&](const sand::pos& neighbor) -> bool {
+				const sand::tile_id* tile = cursor.find_tile(neighbor);
+				return tile && !*tile;
+			};
+			for (xte::u64 tile_y = 0; tile_y < sand::chunk_h; ++tile_y) {
+				for (xte::u64 tile_x = 0; tile_x < sand::chunk_w; ++tile_x) {
+					auto& tile = chunk.at(tile_x, tile_y);
+					const auto tile_pos = sand::pos(pos.x, pos.y, tile_x, tile_y);
+					bool left_empty = empty(tile_pos - sand::pos(0, 0, 1, 0));
+					bool right_empty = empty(tile_pos + sand::pos(0, 0, 1, 0));
+					bool down_empty = empty(tile_pos - sand::pos(0, 0, 0, 1));
+					bool up_empty = empty(tile_pos + sand::pos(0, 0, 0, 1));
+					if (xte::less(std::uniform_int_distribution<xte::u64>(0, 5)(rng), (left_empty + right_empty + down_empty + up_empty)) || !std::uniform_int_distribution<xte::u64>(0, 63)(rng)) {
+						tile = 0x00;
+					} else {
+						tile = std::bernoulli_distribution()(rng) ? 0x02 : 0x07;
+					}
+				}
+			}
+		} else {
+			for (auto& tile : chunk) {
+				tile = static_cast<sand::tile_id>(std::uniform_int_distribution<xte::u64>(0, sand::tiles.size() - 1)(rng));
+			}
+		}
+		world_chunk.histogram = sand::count_tiles(chunk);
+		world_chunk.animated = sand::animated_tiles(chunk, world_chunk.histogram);
+		world_chunk.dirty = true;
+		world_chunk.version = ++sand::world_version;
+		sand::refresh_occupancy(pos, world_chunk);
+		sand::wake_chunk(pos);
+		return world_chunk;
+	}
+}
+
+#endif